@@ -18,6 +18,14 @@
  * -------------------------------------------------------------------
  * Implementation of Conway's Game of Life, with periodic
  * boundary conditions
+ * If ngen is given in the command line the program runs in batch mode:
+ * no prompts or pauses, the grid is output every freq generations
+ * (never if freq is 0 or not given), and wall time, cell updates per second and bytes
+ * per second (2 bytes, the cell read and written, per update) are
+ * reported. Output is written in text to stdout, or if a file name is
+ * given as a packed binary snapshot: n and generation number as ints,
+ * then n rows of (n+7)/8 bytes, with cell j of a row in bit j%8 of
+ * byte j/8.
  */
 
 #include <stdio.h>
@@ -26,6 +34,11 @@
 
 void updateGrid(char **grid, char **newGrid, int n);
 void display(char **grid, int n);
+//append packed binary snapshot of grid at generation gen to file f
+void writeSnapshot(FILE *f, char **grid, int n, int gen);
+//run ngen generations without pausing, outputting grid every freq
+//generations to f (or stdout if f is NULL), and report timing
+void batch(char **grid, char **newGrid, int n, int ngen, int freq, FILE *f);
 char **initialize(int seed, int n);
 char **allocate2D(int n);
 
@@ -36,12 +49,13 @@ int main(int argc, char **argv){
 	char **newGrid; //copy of grid
 
 	if(argc <2){
-		fprintf(stderr,"usage: %s n [seed]\n", argv[0]);
+		fprintf(stderr,"usage: %s n [seed [ngen [freq [file]]]]\n", argv[0]);
+		fprintf(stderr,"(seed -1 uses time)\n");
 		return 1;
 	}
 	n = strtol(argv[1], NULL, 10);
 	int seed;
-	if(3 == argc)
+	if(argc > 2)
 		seed = strtol(argv[2], NULL, 10);
 	else
 		seed = -1;
@@ -51,6 +65,21 @@ int main(int argc, char **argv){
 		fprintf(stderr,"couldn't allocate memory for grid\n");
 		return 1;
 	}
+	if(argc > 3){
+		ngen = strtol(argv[3], NULL, 10);
+		int freq = 0;
+		if(argc > 4)
+			freq = strtol(argv[4], NULL, 10);
+		FILE *f = NULL;
+		if(argc > 5 && (f = fopen(argv[5], "wb")) == NULL){
+			fprintf(stderr,"can't open file %s\n", argv[5]);
+			return 1;
+		}
+		batch(grid, newGrid, n, ngen, freq, f);
+		if(f)
+			fclose(f);
+		return 0;
+	}
 	display(grid, n);
 	printf("enter number of generations: ");
 	scanf("%d", &ngen);
@@ -68,6 +97,41 @@ int main(int argc, char **argv){
 	return 0;
 }
 
+void batch(char **grid, char **newGrid, int n, int ngen, int freq, FILE *f){
+	struct timespec tstart,tend;
+	double timer, ktimer = 0.0; //total time, time in updateGrid
+
+	clock_gettime(CLOCK_MONOTONIC, &tstart);
+	for(int k=1; k<=ngen; k++){
+		struct timespec t0, t1;
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		updateGrid(grid, newGrid, n);
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		ktimer += (t1.tv_sec-t0.tv_sec) + (t1.tv_nsec-t0.tv_nsec)*1.0e-9;
+		char ** temp = grid;
+		grid = newGrid;
+		newGrid = temp;
+		if(freq > 0 && k % freq == 0){
+			if(f)
+				writeSnapshot(f, grid, n, k);
+			else{
+				printf("generation %d\n", k);
+				display(grid, n);
+			}
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &tend);
+  timer = (tend.tv_sec-tstart.tv_sec) +
+        (tend.tv_nsec-tstart.tv_nsec)*1.0e-9;
+	double cells = (double)n*n*ngen;
+	fprintf(stderr, "wall time in s: %f\n", timer);
+	fprintf(stderr, "update time in s: %f\n", ktimer);
+	if(ktimer > 0){
+		fprintf(stderr, "cells/s: %e\n", cells/ktimer);
+		fprintf(stderr, "bytes/s: %e\n", 2*cells/ktimer);
+	}
+}
+
 void updateGrid(char **grid, char **newGrid, int n){
 	for(int i=0; i<n; i++)
 		for(int j=0; j<n; j++){
@@ -98,6 +162,26 @@ void display(char **grid, int n){
 	}
 }
 
+void writeSnapshot(FILE *f, char **grid, int n, int gen){
+	int nb = (n+7)/8; //bytes per row
+	unsigned char *row = malloc(nb);
+	if(!row){
+		fprintf(stderr,"couldn't allocate memory for snapshot\n");
+		exit(1);
+	}
+	fwrite(&n, sizeof(int), 1, f);
+	fwrite(&gen, sizeof(int), 1, f);
+	for(int i=0; i<n; i++){
+		for(int j=0; j<nb; j++)
+			row[j] = 0;
+		for(int j=0; j<n; j++)
+			if(grid[i][j])
+				row[j/8] |= 1 << j%8;
+		fwrite(row, 1, nb, f);
+	}
+	free(row);
+}
+
 char **initialize(int seed, int n){
 	char *temp = calloc(n*n, sizeof(char));
 	char **grid = malloc(n*sizeof(char *));
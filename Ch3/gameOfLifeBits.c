@@ -0,0 +1,389 @@
+/* Copyright 2017 Eric Aubanel
+ * This file contains code extending Algorithm  3.5 from
+ * Elements of Parallel Computing, by Eric Aubanel, 2016, CRC Press.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------
+ * Bit-packed implementation of Conway's Game of Life, with periodic
+ * boundary conditions. Each row of the n x n grid is stored in
+ * w = ceil(n/64) 64-bit words, bit j of word k holding cell 64k+j.
+ * Neighbour counts for 64 cells are computed at once with a bitwise
+ * adder (carry-save) network, so a word needs no more than a few dozen
+ * logical operations. Scalar, AVX2 and AVX-512 versions of the adder
+ * kernel are provided; the best one supported by the processor is
+ * picked at runtime.
+ * The byte-per-cell updateGrid from gameOfLife.c is kept as the
+ * reference: every packed kernel is run for ngen generations from the
+ * same initial grid and checked against it.
+ * Compile with: gcc -O3 -std=gnu99 gameOfLifeBits.c -o gameOfLifeBits
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+//new cells for w words, from the 3 rows above (ul, u, ur), the 2
+//neighbours in the same row (l, r), the row itself (c) and the 3 rows
+//below (dl, d, dr); l and r are the row shifted by one cell
+typedef void (*LifeKernel)(const uint64_t *ul, const uint64_t *u,
+		const uint64_t *ur, const uint64_t *l, const uint64_t *c,
+		const uint64_t *r, const uint64_t *dl, const uint64_t *d,
+		const uint64_t *dr, uint64_t *out, int w);
+
+//reference byte kernel, from gameOfLife.c
+void updateGrid(char **grid, char **newGrid, int n);
+//update packed grid bits into newBits using kernel, with w words per row
+//shift holds 6 rows of w words used for shifted copies of rows
+void updateBits(uint64_t **bits, uint64_t **newBits, int n, int w,
+		uint64_t **shift, LifeKernel kernel);
+//store in left (right) row r shifted so each cell holds its left
+//(right) neighbour, with periodic boundary
+void shiftRow(const uint64_t *r, uint64_t *left, uint64_t *right, int n, int w);
+void lifeWordsScalar(const uint64_t *ul, const uint64_t *u,
+		const uint64_t *ur, const uint64_t *l, const uint64_t *c,
+		const uint64_t *r, const uint64_t *dl, const uint64_t *d,
+		const uint64_t *dr, uint64_t *out, int w);
+#ifdef __x86_64__
+void lifeWordsAVX2(const uint64_t *ul, const uint64_t *u,
+		const uint64_t *ur, const uint64_t *l, const uint64_t *c,
+		const uint64_t *r, const uint64_t *dl, const uint64_t *d,
+		const uint64_t *dr, uint64_t *out, int w);
+void lifeWordsAVX512(const uint64_t *ul, const uint64_t *u,
+		const uint64_t *ur, const uint64_t *l, const uint64_t *c,
+		const uint64_t *r, const uint64_t *dl, const uint64_t *d,
+		const uint64_t *dr, uint64_t *out, int w);
+#endif
+//returns fastest kernel supported by processor, and its name in name
+LifeKernel selectKernel(const char **name);
+//pack byte grid into bits
+void pack(char **grid, uint64_t **bits, int n);
+//returns index of first cell where grid and bits differ, or -1
+long compareGrids(char **grid, uint64_t **bits, int n);
+char **initialize(int seed, int n);
+char **allocate2D(int n);
+//allocate m rows of w words, initialized to 0
+uint64_t **allocateBits(int m, int w);
+//runs kernel for ngen generations from grid0, returns time in s
+double runBits(char **grid0, uint64_t **bits, uint64_t **newBits,
+		uint64_t **shift, int n, int w, int ngen, LifeKernel kernel);
+
+int main(int argc, char **argv){
+	int n; // n x n grid
+	int ngen; // number of generations
+	char **grid; // Game grid
+	char **newGrid; //copy of grid
+	char **grid0; //initial grid
+	struct timespec tstart,tend;
+	double timer;
+
+	if(argc <3){
+		fprintf(stderr,"usage: %s n ngen [seed]\n", argv[0]);
+		return 1;
+	}
+	n = strtol(argv[1], NULL, 10);
+	ngen = strtol(argv[2], NULL, 10);
+	int seed;
+	if(4 == argc)
+		seed = strtol(argv[3], NULL, 10);
+	else
+		seed = -1;
+	int w = (n+63)/64; //words per row
+	grid0 = initialize(seed, n);
+	grid = allocate2D(n);
+	newGrid = allocate2D(n);
+	uint64_t **bits = allocateBits(n, w);
+	uint64_t **newBits = allocateBits(n, w);
+	uint64_t **shift = allocateBits(6, w);
+	if(!grid0 || !grid || !newGrid || !bits || !newBits || !shift){
+		fprintf(stderr,"couldn't allocate memory for grid\n");
+		return 1;
+	}
+	double cells = (double)n*n*ngen;
+
+	//reference byte kernel
+	memcpy(grid[0], grid0[0], (size_t)n*n);
+	clock_gettime(CLOCK_MONOTONIC, &tstart);
+	for(int k=0; k<ngen; k++){
+		updateGrid(grid, newGrid, n);
+		char ** temp = grid;
+		grid = newGrid;
+		newGrid = temp;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &tend);
+  timer = (tend.tv_sec-tstart.tv_sec) +
+        (tend.tv_nsec-tstart.tv_nsec)*1.0e-9;
+	printf("byte kernel time in s: %f (%.1f Mcells/s)\n", timer,
+			cells/timer*1e-6);
+
+	const char *names[] = {"scalar", "avx2", "avx512"};
+	LifeKernel kernels[] = {lifeWordsScalar, NULL, NULL};
+	#ifdef __x86_64__
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2"))
+		kernels[1] = lifeWordsAVX2;
+	if(__builtin_cpu_supports("avx512f"))
+		kernels[2] = lifeWordsAVX512;
+	#endif
+	const char *best;
+	selectKernel(&best);
+	printf("selected packed kernel: %s\n", best);
+
+	int passed = 1;
+	for(int i=0; i<3; i++){
+		if(!kernels[i])
+			continue;
+		timer = runBits(grid0, bits, newBits, shift, n, w, ngen, kernels[i]);
+		//runBits leaves result in bits if ngen is even, otherwise in newBits
+		long diff = compareGrids(grid, ngen%2 ? newBits : bits, n);
+		printf("%s packed kernel time in s: %f (%.1f Mcells/s)\n", names[i],
+				timer, cells/timer*1e-6);
+		if(diff >= 0){
+			printf("%s kernel differs at cell (%ld, %ld)\n", names[i], diff/n,
+					diff%n);
+			passed = 0;
+		}
+	}
+	if(passed)
+		printf("result verified\n");
+	return 0;
+}
+
+double runBits(char **grid0, uint64_t **bits, uint64_t **newBits,
+		uint64_t **shift, int n, int w, int ngen, LifeKernel kernel){
+	struct timespec tstart,tend;
+	pack(grid0, bits, n);
+	clock_gettime(CLOCK_MONOTONIC, &tstart);
+	for(int k=0; k<ngen; k++){
+		updateBits(bits, newBits, n, w, shift, kernel);
+		uint64_t ** temp = bits;
+		bits = newBits;
+		newBits = temp;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &tend);
+  return (tend.tv_sec-tstart.tv_sec) +
+        (tend.tv_nsec-tstart.tv_nsec)*1.0e-9;
+}
+
+void updateGrid(char **grid, char **newGrid, int n){
+	for(int i=0; i<n; i++)
+		for(int j=0; j<n; j++){
+			int up = (i-1+n)%n;
+			int down = (i+1)%n;
+			int left = (j-1+n)%n;
+			int right = (j+1)%n;
+			int sumAlive = grid[up][left] + grid[up][j] + grid[up][right] +
+					grid[i][left] + grid[i][right] +
+					grid[down][left] + grid[down][j] + grid[down][right];
+			if(0 == grid[i][j] && 3 == sumAlive)
+				newGrid[i][j] = 1;
+			else if( 1 == grid[i][j] && (2 == sumAlive || 3 == sumAlive))
+				newGrid[i][j] = 1;
+			else
+				newGrid[i][j] = 0;
+		}
+}
+
+void updateBits(uint64_t **bits, uint64_t **newBits, int n, int w,
+		uint64_t **shift, LifeKernel kernel){
+	//shifted copies of rows above, at and below row i
+	uint64_t *lu = shift[0], *ru = shift[1];
+	uint64_t *lc = shift[2], *rc = shift[3];
+	uint64_t *ld = shift[4], *rd = shift[5];
+	uint64_t mask = (n%64) ? (UINT64_C(1) << n%64) - 1 : ~UINT64_C(0);
+	shiftRow(bits[n-1], lu, ru, n, w);
+	shiftRow(bits[0], lc, rc, n, w);
+	for(int i=0; i<n; i++){
+		int up = i ? i-1 : n-1;
+		int down = (i+1 < n) ? i+1 : 0;
+		shiftRow(bits[down], ld, rd, n, w);
+		kernel(lu, bits[up], ru, lc, bits[i], rc, ld, bits[down], rd,
+				newBits[i], w);
+		//clear cells past column n-1
+		newBits[i][w-1] &= mask;
+		uint64_t *tl = lu, *tr = ru;
+		lu = lc; ru = rc;
+		lc = ld; rc = rd;
+		ld = tl; rd = tr;
+	}
+}
+
+void shiftRow(const uint64_t *r, uint64_t *left, uint64_t *right, int n, int w){
+	int last = (n-1)%64; //position of column n-1 in last word
+	left[0] = (r[0] << 1) | ((r[w-1] >> last) & 1);
+	for(int k=1; k<w; k++)
+		left[k] = (r[k] << 1) | (r[k-1] >> 63);
+	for(int k=0; k<w-1; k++)
+		right[k] = (r[k] >> 1) | (r[k+1] << 63);
+	right[w-1] = (r[w-1] >> 1) | ((r[0] & 1) << last);
+}
+
+/* Bitwise adder: counts 8 neighbours per bit position as 3 bits
+ * s2 s1 s0 (a count of 8 wraps to 0, which is dead in any case).
+ * A cell is alive next if count is 3, or count is 2 and it is alive.
+ */
+#define LIFE_WORD(T, AND, OR, XOR, ANDNOT, ul, u, ur, l, c, r, dl, d, dr, out) \
+	{ \
+		T xa = XOR(ul, u); \
+		T sa = XOR(xa, ur); \
+		T ca = OR(AND(ul, u), AND(ur, xa)); \
+		T xb = XOR(l, r); \
+		T sb = XOR(xb, dl); \
+		T cb = OR(AND(l, r), AND(dl, xb)); \
+		T sc = XOR(d, dr); \
+		T cc = AND(d, dr); \
+		T xs = XOR(sa, sb); \
+		T s0 = XOR(xs, sc); \
+		T c1 = OR(AND(sa, sb), AND(sc, xs)); \
+		T xt = XOR(ca, cb); \
+		T pt = XOR(xt, cc); \
+		T qt = OR(AND(ca, cb), AND(cc, xt)); \
+		T s1 = XOR(pt, c1); \
+		T s2 = XOR(qt, AND(pt, c1)); \
+		out = ANDNOT(s2, AND(s1, OR(s0, c))); \
+	}
+
+#define AND64(a, b) ((a) & (b))
+#define OR64(a, b) ((a) | (b))
+#define XOR64(a, b) ((a) ^ (b))
+#define ANDNOT64(a, b) (~(a) & (b))
+
+void lifeWordsScalar(const uint64_t *ul, const uint64_t *u,
+		const uint64_t *ur, const uint64_t *l, const uint64_t *c,
+		const uint64_t *r, const uint64_t *dl, const uint64_t *d,
+		const uint64_t *dr, uint64_t *out, int w){
+	for(int k=0; k<w; k++)
+		LIFE_WORD(uint64_t, AND64, OR64, XOR64, ANDNOT64, ul[k], u[k], ur[k],
+				l[k], c[k], r[k], dl[k], d[k], dr[k], out[k])
+}
+
+#ifdef __x86_64__
+__attribute__((target("avx2")))
+void lifeWordsAVX2(const uint64_t *ul, const uint64_t *u,
+		const uint64_t *ur, const uint64_t *l, const uint64_t *c,
+		const uint64_t *r, const uint64_t *dl, const uint64_t *d,
+		const uint64_t *dr, uint64_t *out, int w){
+	int k;
+	#define LD(p) _mm256_loadu_si256((const __m256i *)(p+k))
+	for(k=0; k+4<=w; k+=4){
+		__m256i res;
+		LIFE_WORD(__m256i, _mm256_and_si256, _mm256_or_si256, _mm256_xor_si256,
+				_mm256_andnot_si256, LD(ul), LD(u), LD(ur), LD(l), LD(c), LD(r),
+				LD(dl), LD(d), LD(dr), res)
+		_mm256_storeu_si256((__m256i *)(out+k), res);
+	}
+	#undef LD
+	//avoid AVX-SSE transition penalty in the (non-VEX) scalar code
+	_mm256_zeroupper();
+	//remaining words
+	lifeWordsScalar(ul+k, u+k, ur+k, l+k, c+k, r+k, dl+k, d+k, dr+k, out+k, w-k);
+}
+
+__attribute__((target("avx512f")))
+void lifeWordsAVX512(const uint64_t *ul, const uint64_t *u,
+		const uint64_t *ur, const uint64_t *l, const uint64_t *c,
+		const uint64_t *r, const uint64_t *dl, const uint64_t *d,
+		const uint64_t *dr, uint64_t *out, int w){
+	int k;
+	#define LD(p) _mm512_loadu_si512((const void *)(p+k))
+	for(k=0; k+8<=w; k+=8){
+		__m512i res;
+		LIFE_WORD(__m512i, _mm512_and_si512, _mm512_or_si512, _mm512_xor_si512,
+				_mm512_andnot_si512, LD(ul), LD(u), LD(ur), LD(l), LD(c), LD(r),
+				LD(dl), LD(d), LD(dr), res)
+		_mm512_storeu_si512((void *)(out+k), res);
+	}
+	#undef LD
+	//avoid AVX-SSE transition penalty in the (non-VEX) scalar code
+	_mm256_zeroupper();
+	//remaining words
+	lifeWordsScalar(ul+k, u+k, ur+k, l+k, c+k, r+k, dl+k, d+k, dr+k, out+k, w-k);
+}
+#endif
+
+LifeKernel selectKernel(const char **name){
+	#ifdef __x86_64__
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx512f")){
+		*name = "avx512";
+		return lifeWordsAVX512;
+	}
+	if(__builtin_cpu_supports("avx2")){
+		*name = "avx2";
+		return lifeWordsAVX2;
+	}
+	#endif
+	*name = "scalar";
+	return lifeWordsScalar;
+}
+
+void pack(char **grid, uint64_t **bits, int n){
+	int w = (n+63)/64;
+	for(int i=0; i<n; i++){
+		memset(bits[i], 0, w*sizeof(uint64_t));
+		for(int j=0; j<n; j++)
+			if(grid[i][j])
+				bits[i][j/64] |= UINT64_C(1) << j%64;
+	}
+}
+
+long compareGrids(char **grid, uint64_t **bits, int n){
+	for(int i=0; i<n; i++)
+		for(int j=0; j<n; j++)
+			if(grid[i][j] != (char)((bits[i][j/64] >> j%64) & 1))
+				return (long)i*n + j;
+	return -1;
+}
+
+char **initialize(int seed, int n){
+	char *temp = calloc((size_t)n*n, sizeof(char));
+	char **grid = malloc(n*sizeof(char *));
+	if(!temp || !grid)
+		return NULL;
+	if(-1 == seed)
+		srand(time(NULL));
+	else
+		srand(seed);
+	for(size_t i=0; i<(size_t)n*n; i++)
+		if(rand() > RAND_MAX/2)
+			temp[i] = 1;
+	for(int i=0; i<n; i++)
+		grid[i] = temp + (size_t)i*n;
+	return grid;
+}
+
+char **allocate2D(int n){
+		char *temp = malloc((size_t)n*n*sizeof(char));
+		char **a = malloc(n*sizeof(char *));
+		if(!temp || !a)
+			return NULL;
+		for(int i=0; i<n; i++)
+			a[i] = temp + (size_t)i*n;
+		return a;
+}
+
+uint64_t **allocateBits(int m, int w){
+		uint64_t *temp = calloc((size_t)m*w, sizeof(uint64_t));
+		uint64_t **a = malloc(m*sizeof(uint64_t *));
+		if(!temp || !a)
+			return NULL;
+		for(int i=0; i<m; i++)
+			a[i] = temp + (size_t)i*w;
+		return a;
+}
@@ -0,0 +1,650 @@
+/* Copyright 2017 Eric Aubanel
+ * This file contains code extending Algorithm  3.5 from
+ * Elements of Parallel Computing, by Eric Aubanel, 2016, CRC Press.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------
+ * Sparse implementations of Conway's Game of Life, with periodic
+ * boundary conditions, for mostly dead grids too large to store densely.
+ * Only an r x r square in the centre of the n x n grid is initialized
+ * with random values. Two engines are provided:
+ * tiles: the grid is divided into TILE x TILE tiles, and only tiles
+ *   that contain live cells are stored, in a hash table. A tile is only
+ *   updated if it or one of its 8 neighbours changed in the previous
+ *   generation; all other tiles are quiescent and are skipped.
+ *   Requires n divisible by TILE.
+ * hashlife: Gosper's HashLife. The grid is a quadtree whose nodes are
+ *   hash-consed, so identical subtrees are stored once, and the result
+ *   of advancing a node 2^j generations is memoized in the node. The
+ *   number of generations is advanced in jumps of 2^j, largest first.
+ *   The torus is handled by advancing a node made of 2 x 2 copies of the
+ *   grid, whose centre is the grid shifted by n/2 in each direction.
+ *   Requires n to be a power of 2.
+ * Memory use is limited to maxMB megabytes (default 1024). When the
+ * HashLife node pool fills, nodes not reachable from the grid are
+ * garbage collected, and the jump is retried with half the step if
+ * needed. Peak memory is reported.
+ * For n <= 2048 results are checked against the dense updateGrid.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <time.h>
+
+#define TILE 64
+#define VERIFY_MAX 2048
+
+//reference dense update, from gameOfLife.c
+void updateGrid(char **grid, char **newGrid, int n);
+char **allocate2D(int n);
+//value of cell (i,j) of initial grid: random in central r x r square
+char initialCell(long i, long j);
+
+// ---------------- active tiles ----------------
+typedef struct Tile{
+	long ti, tj; //tile coordinates
+	char *cur, *next; //cells of current and next generation
+	int changed; //changed in last generation
+	int queued; //in list of tiles to update
+	int idx; //index in array of tiles
+	struct Tile *hnext; //next tile in hash chain
+} Tile;
+
+//run tiles engine for ngen generations; if grid not NULL store result
+//in it; returns final population
+long long runTiles(long n, int ngen, size_t maxBytes, char **grid);
+//returns tile (ti,tj), creating an empty one if create is set
+Tile *getTile(long ti, long tj, int create);
+//remove tile from table and free it
+void freeTile(Tile *t);
+//next generation of tile t, from t and its 8 neighbours
+void updateTile(Tile *t, long nt);
+
+// ---------------- HashLife ----------------
+typedef struct{
+	int nw, ne, sw, se; //children, or -1 for the 2 leaves (cells)
+	int level; //node covers 2^level x 2^level cells
+	int result; //centre after 2^step generations, or -1
+	int next; //next node in hash chain
+	long long pop; //number of live cells
+} Node;
+
+//run HashLife for ngen generations; if grid not NULL store result in it;
+//returns final population
+long long runHashLife(int logn, int ngen, size_t maxBytes, char **grid);
+//canonical node with given children
+int join(int nw, int ne, int sw, int se);
+//canonical empty node of given level
+int emptyNode(int level);
+//build node of given level covering cells from (i0,j0) of initial grid
+int build(int level, long i0, long j0);
+//centre of node of level L after 2^min(step,L-2) generations (level L-1)
+int result(int node);
+//centre of node, not advanced
+int centre(int node);
+//level 2 base case: centre 2x2 after 1 generation
+int baseCase(int node);
+//advance root 2^j generations (node twice the size of root is built
+//from 4 copies); returns -1 if node pool becomes full
+int advance(int root, int j);
+//collect nodes not reachable from root or empty nodes, returns new root
+int collect(int root);
+//write cells of node to grid, with offset o and periodic wrap
+void flatten(int node, long i0, long j0, long o, long n, char **grid);
+
+long r; //side of initialized square
+long c0; //first row and column of initialized square
+char *square; //initial values of square
+
+int main(int argc, char **argv){
+	long n; // n x n grid
+	int ngen; // number of generations
+	int seed = -1;
+	size_t maxMB = 1024;
+	struct timespec tstart,tend;
+	double timer;
+
+	if(argc <4){
+		fprintf(stderr,"usage: %s tiles|hashlife n ngen [seed [r [maxMB]]]\n",
+				argv[0]);
+		return 1;
+	}
+	int hash = !strcmp(argv[1], "hashlife");
+	if(!hash && strcmp(argv[1], "tiles")){
+		fprintf(stderr,"unknown engine %s\n", argv[1]);
+		return 1;
+	}
+	n = strtol(argv[2], NULL, 10);
+	ngen = strtol(argv[3], NULL, 10);
+	if(argc > 4)
+		seed = strtol(argv[4], NULL, 10);
+	r = n < 256 ? n : 256;
+	if(argc > 5)
+		r = strtol(argv[5], NULL, 10);
+	if(argc > 6)
+		maxMB = strtol(argv[6], NULL, 10);
+	int logn = 0;
+	while((1L << logn) < n)
+		logn++;
+	if(hash && ((1L << logn) != n || n < 8)){
+		fprintf(stderr,"n must be a power of 2, at least 8\n");
+		return 1;
+	}
+	if(!hash && n%TILE){
+		fprintf(stderr,"n must be divisible by %d\n", TILE);
+		return 1;
+	}
+	if(r > n || r > 65536){
+		fprintf(stderr,"r must be at most n and 65536\n");
+		return 1;
+	}
+	c0 = (n-r)/2;
+	if((square = malloc(r*r)) == NULL){
+		fprintf(stderr,"couldn't allocate memory for initial square\n");
+		return 1;
+	}
+	if(-1 == seed)
+		srand(time(NULL));
+	else
+		srand(seed);
+	for(long i=0; i<r*r; i++)
+		square[i] = rand() > RAND_MAX/2;
+
+	char **grid = NULL;
+	if(n <= VERIFY_MAX){
+		grid = allocate2D(n);
+		if(!grid){
+			fprintf(stderr,"couldn't allocate memory for grid\n");
+			return 1;
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &tstart);
+	long long pop;
+	if(hash)
+		pop = runHashLife(logn, ngen, maxMB << 20, grid);
+	else
+		pop = runTiles(n, ngen, maxMB << 20, grid);
+	clock_gettime(CLOCK_MONOTONIC, &tend);
+  timer = (tend.tv_sec-tstart.tv_sec) +
+        (tend.tv_nsec-tstart.tv_nsec)*1.0e-9;
+	printf("population after %d generations: %lld\n", ngen, pop);
+	printf("time in s: %f (%e cell-updates/s)\n", timer,
+			(double)n*n*ngen/timer);
+
+	if(grid){
+		char **ref = allocate2D(n);
+		char **newRef = allocate2D(n);
+		if(!ref || !newRef){
+			fprintf(stderr,"couldn't allocate memory for reference grid\n");
+			return 1;
+		}
+		for(long i=0; i<n; i++)
+			for(long j=0; j<n; j++)
+				ref[i][j] = initialCell(i, j);
+		for(int k=0; k<ngen; k++){
+			updateGrid(ref, newRef, n);
+			char ** temp = ref;
+			ref = newRef;
+			newRef = temp;
+		}
+		if(memcmp(grid[0], ref[0], n*n))
+			printf("result differs from dense updateGrid\n");
+		else
+			printf("result verified\n");
+	}
+	return 0;
+}
+
+char initialCell(long i, long j){
+	i -= c0;
+	j -= c0;
+	if(i < 0 || i >= r || j < 0 || j >= r)
+		return 0;
+	return square[i*r+j];
+}
+
+// ---------------- active tiles ----------------
+
+Tile **table; //hash table of tiles
+long tableSize; //power of 2
+Tile **tiles; //all tiles
+long ntiles, maxTiles;
+
+long long runTiles(long n, int ngen, size_t maxBytes, char **grid){
+	long nt = n/TILE; //tiles per row and column
+	size_t tileBytes = sizeof(Tile) + 2*TILE*TILE + 2*sizeof(Tile *);
+	maxTiles = maxBytes/tileBytes;
+	if(maxTiles > nt*nt)
+		maxTiles = nt*nt;
+	for(tableSize=1; 2*tableSize <= maxTiles; tableSize <<= 1)
+		;
+	table = calloc(tableSize, sizeof(Tile *));
+	tiles = malloc(maxTiles*sizeof(Tile *));
+	Tile **list = malloc(maxTiles*sizeof(Tile *)); //tiles to update
+	if(!table || !tiles || !list){
+		fprintf(stderr,"couldn't allocate memory for tiles\n");
+		exit(1);
+	}
+	for(long ti=c0/TILE; ti<=(c0+r-1)/TILE; ti++)
+		for(long tj=c0/TILE; tj<=(c0+r-1)/TILE; tj++){
+			Tile *t = getTile(ti, tj, 1);
+			for(int i=0; i<TILE; i++)
+				for(int j=0; j<TILE; j++)
+					t->cur[i*TILE+j] = initialCell(ti*TILE+i, tj*TILE+j);
+			t->changed = 1;
+		}
+
+	long peak = ntiles;
+	double updated = 0.0; //number of tile updates
+	for(int k=0; k<ngen; k++){
+		//tiles that changed and their neighbours are updated
+		long nlist = 0;
+		long nchanged = 0;
+		for(long i=0; i<ntiles; i++)
+			if(tiles[i]->changed)
+				list[nchanged++] = tiles[i];
+		for(long c=0; c<nchanged; c++){
+			Tile *t = list[c];
+			for(int di=-1; di<=1; di++)
+				for(int dj=-1; dj<=1; dj++){
+					Tile *u = getTile((t->ti+di+nt)%nt, (t->tj+dj+nt)%nt, 1);
+					u->queued = 1;
+				}
+		}
+		for(long i=0; i<ntiles; i++)
+			if(tiles[i]->queued)
+				list[nlist++] = tiles[i];
+		for(long i=0; i<nlist; i++)
+			updateTile(list[i], nt);
+		//all tiles of generation allocated, before dead ones are freed
+		if(ntiles > peak)
+			peak = ntiles;
+		for(long i=0; i<nlist; i++){
+			Tile *t = list[i];
+			char *temp = t->cur;
+			t->cur = t->next;
+			t->next = temp;
+			t->queued = 0;
+			if(!t->changed && !memchr(t->cur, 1, TILE*TILE))
+				freeTile(t);
+		}
+		updated += nlist;
+	}
+	printf("peak tiles: %ld, peak memory: %.1f MB\n", peak,
+			(peak*tileBytes + tableSize*sizeof(Tile *))/1048576.0);
+	printf("average fraction of grid updated: %f\n",
+			ngen ? updated/ngen/((double)nt*nt) : 0.0);
+
+	long long pop = 0;
+	for(long i=0; i<ntiles; i++){
+		Tile *t = tiles[i];
+		for(int c=0; c<TILE*TILE; c++)
+			pop += t->cur[c];
+	}
+	if(grid){
+		memset(grid[0], 0, n*n);
+		for(long i=0; i<ntiles; i++){
+			Tile *t = tiles[i];
+			for(int a=0; a<TILE; a++)
+				memcpy(&grid[t->ti*TILE+a][t->tj*TILE], &t->cur[a*TILE], TILE);
+		}
+	}
+	return pop;
+}
+
+Tile *getTile(long ti, long tj, int create){
+	long h = (ti*0x9E3779B1L + tj) & (tableSize-1);
+	for(Tile *t = table[h]; t; t = t->hnext)
+		if(t->ti == ti && t->tj == tj)
+			return t;
+	if(!create)
+		return NULL;
+	if(ntiles == maxTiles){
+		fprintf(stderr,"memory limit reached: more than %ld tiles\n", maxTiles);
+		exit(1);
+	}
+	Tile *t = malloc(sizeof(Tile));
+	char *cells = calloc(2*TILE*TILE, 1);
+	if(!t || !cells){
+		fprintf(stderr,"couldn't allocate memory for tile\n");
+		exit(1);
+	}
+	t->ti = ti;
+	t->tj = tj;
+	t->cur = cells;
+	t->next = cells + TILE*TILE;
+	t->changed = t->queued = 0;
+	t->hnext = table[h];
+	table[h] = t;
+	t->idx = ntiles;
+	tiles[ntiles++] = t;
+	return t;
+}
+
+void freeTile(Tile *t){
+	long h = (t->ti*0x9E3779B1L + t->tj) & (tableSize-1);
+	Tile **p = &table[h];
+	while(*p != t)
+		p = &(*p)->hnext;
+	*p = t->hnext;
+	tiles[t->idx] = tiles[--ntiles];
+	tiles[t->idx]->idx = t->idx;
+	//cur and next share one allocation
+	free(t->cur < t->next ? t->cur : t->next);
+	free(t);
+}
+
+void updateTile(Tile *t, long nt){
+	const int L = TILE+2;
+	char a[(TILE+2)*(TILE+2)]; //tile with border of neighbouring cells
+	for(int di=-1; di<=1; di++)
+		for(int dj=-1; dj<=1; dj++){
+			Tile *u = getTile((t->ti+di+nt)%nt, (t->tj+dj+nt)%nt, 0);
+			//rows and columns of u that border t
+			int ilo = di < 0 ? TILE-1 : 0, ihi = di > 0 ? 1 : TILE;
+			int jlo = dj < 0 ? TILE-1 : 0, jhi = dj > 0 ? 1 : TILE;
+			for(int i=ilo; i<ihi; i++)
+				for(int j=jlo; j<jhi; j++){
+					int ai = i + 1 + di*TILE, aj = j + 1 + dj*TILE;
+					a[ai*L+aj] = u ? u->cur[i*TILE+j] : 0;
+				}
+		}
+	t->changed = 0;
+	for(int i=1; i<=TILE; i++)
+		for(int j=1; j<=TILE; j++){
+			int sumAlive = a[(i-1)*L+j-1] + a[(i-1)*L+j] + a[(i-1)*L+j+1] +
+					a[i*L+j-1] + a[i*L+j+1] +
+					a[(i+1)*L+j-1] + a[(i+1)*L+j] + a[(i+1)*L+j+1];
+			char alive = a[i*L+j];
+			char next = (3 == sumAlive) | (2 == sumAlive && alive);
+			t->next[(i-1)*TILE+j-1] = next;
+			t->changed |= next != alive;
+		}
+}
+
+// ---------------- HashLife ----------------
+
+Node *pool; //nodes; 0 and 1 are the dead and live cells
+int nnodes, maxNodes;
+int *heads; //hash table heads
+int hashSize; //power of 2
+int empty[64]; //empty node of each level, or -1
+int step; //log2 of generations advanced by result at current level
+jmp_buf full; //where to go when pool is full
+
+long long runHashLife(int logn, int ngen, size_t maxBytes, char **grid){
+	long n = 1L << logn;
+	size_t nodeBytes = sizeof(Node) + 2*sizeof(int) + 1;
+	maxNodes = maxBytes/nodeBytes;
+	for(hashSize=1; 2*hashSize <= maxNodes; hashSize <<= 1)
+		;
+	pool = malloc(maxNodes*sizeof(Node));
+	heads = malloc(hashSize*sizeof(int));
+	if(!pool || !heads || maxNodes < 1024){
+		fprintf(stderr,"couldn't allocate memory for nodes\n");
+		exit(1);
+	}
+	for(int i=0; i<hashSize; i++)
+		heads[i] = -1;
+	for(int i=0; i<2; i++)
+		pool[i] = (Node){-1, -1, -1, -1, 0, -1, -1, i};
+	nnodes = 2;
+	for(int l=0; l<64; l++)
+		empty[l] = -1;
+
+	if(setjmp(full)){
+		//pool filled by initial grid
+		fprintf(stderr,"memory limit too small\n");
+		exit(1);
+	}
+	int root = build(logn, 0, 0);
+	long o = 0; //cell (i,j) is at ((i+o)%n, (j+o)%n) of root
+	int peak = nnodes, ngc = 0;
+	int remaining = ngen;
+	step = -1;
+	while(remaining > 0){
+		int j = 0;
+		while(j < logn-1 && (2 << j) <= remaining)
+			j++;
+		int res, tries = 0;
+		while((res = advance(root, j)) == -1){
+			//pool full: collect garbage and retry, with smaller step if
+			//collection didn't free enough
+			peak = maxNodes;
+			root = collect(root);
+			ngc++;
+			if(tries++ && j > 0)
+				j--;
+			else if(tries > 2){
+				fprintf(stderr,"memory limit too small\n");
+				exit(1);
+			}
+		}
+		root = res;
+		o = (o + n/2)%n;
+		remaining -= 1 << j;
+		if(nnodes > peak)
+			peak = nnodes;
+	}
+	printf("peak nodes: %d, peak memory: %.1f MB, garbage collections: %d\n",
+			peak, ((double)peak*nodeBytes + hashSize*sizeof(int))/1048576.0, ngc);
+	if(grid){
+		memset(grid[0], 0, n*n);
+		flatten(root, 0, 0, o, n, grid);
+	}
+	return pool[root].pop;
+}
+
+int advance(int root, int j){
+	if(setjmp(full))
+		return -1;
+	if(j != step){
+		//memoized results are for old step
+		for(int i=2; i<nnodes; i++)
+			pool[i].result = -1;
+		step = j;
+	}
+	return result(join(root, root, root, root));
+}
+
+int join(int nw, int ne, int sw, int se){
+	uint64_t h = ((uint64_t)nw*0x9E3779B97F4A7C15ULL) ^
+			((uint64_t)ne*0xC2B2AE3D27D4EB4FULL) ^
+			((uint64_t)sw*0x165667B19E3779F9ULL) ^ ((uint64_t)se*0x27D4EB2F165667C5ULL);
+	int b = (int)((h ^ (h >> 29)) & (hashSize-1));
+	for(int i=heads[b]; i != -1; i=pool[i].next){
+		Node *p = &pool[i];
+		if(p->nw == nw && p->ne == ne && p->sw == sw && p->se == se)
+			return i;
+	}
+	if(nnodes == maxNodes)
+		longjmp(full, 1);
+	Node *p = &pool[nnodes];
+	p->nw = nw; p->ne = ne; p->sw = sw; p->se = se;
+	p->level = pool[nw].level + 1;
+	p->result = -1;
+	p->pop = pool[nw].pop + pool[ne].pop + pool[sw].pop + pool[se].pop;
+	p->next = heads[b];
+	heads[b] = nnodes;
+	return nnodes++;
+}
+
+int emptyNode(int level){
+	if(0 == level)
+		return 0;
+	if(empty[level] == -1){
+		int e = emptyNode(level-1);
+		empty[level] = join(e, e, e, e);
+	}
+	return empty[level];
+}
+
+int build(int level, long i0, long j0){
+	long s = 1L << level;
+	if(i0 + s <= c0 || i0 >= c0 + r || j0 + s <= c0 || j0 >= c0 + r)
+		return emptyNode(level);
+	if(0 == level)
+		return initialCell(i0, j0);
+	long h = s/2;
+	return join(build(level-1, i0, j0), build(level-1, i0, j0+h),
+			build(level-1, i0+h, j0), build(level-1, i0+h, j0+h));
+}
+
+int centre(int node){
+	Node *p = &pool[node];
+	return join(pool[p->nw].se, pool[p->ne].sw, pool[p->sw].ne, pool[p->se].nw);
+}
+
+int baseCase(int node){
+	char c[4][4];
+	Node *p = &pool[node];
+	int q[4] = {p->nw, p->ne, p->sw, p->se};
+	for(int k=0; k<4; k++){
+		Node *s = &pool[q[k]];
+		int i = 2*(k/2), j = 2*(k%2);
+		c[i][j] = s->nw; c[i][j+1] = s->ne;
+		c[i+1][j] = s->sw; c[i+1][j+1] = s->se;
+	}
+	int out[4];
+	for(int k=0; k<4; k++){
+		int i = 1 + k/2, j = 1 + k%2;
+		int sumAlive = c[i-1][j-1] + c[i-1][j] + c[i-1][j+1] + c[i][j-1] +
+				c[i][j+1] + c[i+1][j-1] + c[i+1][j] + c[i+1][j+1];
+		out[k] = (3 == sumAlive) | (2 == sumAlive && c[i][j]);
+	}
+	return join(out[0], out[1], out[2], out[3]);
+}
+
+int result(int node){
+	if(pool[node].result != -1)
+		return pool[node].result;
+	int L = pool[node].level;
+	int res;
+	if(2 == L)
+		res = baseCase(node);
+	else if(pool[node].pop == 0)
+		res = emptyNode(L-1);
+	else{
+		Node p = pool[node];
+		Node nw = pool[p.nw], ne = pool[p.ne], sw = pool[p.sw], se = pool[p.se];
+		//9 overlapping subnodes of level L-1
+		int n00 = p.nw, n02 = p.ne, n20 = p.sw, n22 = p.se;
+		int n01 = join(nw.ne, ne.nw, nw.se, ne.sw);
+		int n10 = join(nw.sw, nw.se, sw.nw, sw.ne);
+		int n11 = join(nw.se, ne.sw, sw.ne, se.nw);
+		int n12 = join(ne.sw, ne.se, se.nw, se.ne);
+		int n21 = join(sw.ne, se.nw, sw.se, se.sw);
+		int (*first)(int) = (step >= L-2) ? result : centre;
+		int r00 = first(n00), r01 = first(n01), r02 = first(n02);
+		int r10 = first(n10), r11 = first(n11), r12 = first(n12);
+		int r20 = first(n20), r21 = first(n21), r22 = first(n22);
+		res = join(result(join(r00, r01, r10, r11)), result(join(r01, r02, r11, r12)),
+				result(join(r10, r11, r20, r21)), result(join(r11, r12, r21, r22)));
+	}
+	pool[node].result = res;
+	return res;
+}
+
+int collect(int root){
+	char *mark = calloc(nnodes, 1);
+	int *map = malloc(nnodes*sizeof(int));
+	int *stack = malloc(nnodes*sizeof(int));
+	if(!mark || !map || !stack){
+		fprintf(stderr,"couldn't allocate memory for garbage collection\n");
+		exit(1);
+	}
+	int top = 0;
+	stack[top++] = root;
+	for(int l=0; l<64; l++)
+		if(empty[l] != -1)
+			stack[top++] = empty[l];
+	while(top){
+		int i = stack[--top];
+		if(mark[i] || i < 2)
+			continue;
+		mark[i] = 1;
+		stack[top++] = pool[i].nw; stack[top++] = pool[i].ne;
+		stack[top++] = pool[i].sw; stack[top++] = pool[i].se;
+	}
+	//children always precede parents, so compact in order
+	for(int i=0; i<hashSize; i++)
+		heads[i] = -1;
+	map[0] = 0;
+	map[1] = 1;
+	int old = nnodes;
+	nnodes = 2;
+	for(int i=2; i<old; i++)
+		if(mark[i]){
+			Node p = pool[i];
+			map[i] = join(map[p.nw], map[p.ne], map[p.sw], map[p.se]);
+		}
+	root = map[root];
+	for(int l=0; l<64; l++)
+		if(empty[l] != -1)
+			empty[l] = map[empty[l]];
+	for(int i=2; i<nnodes; i++)
+		pool[i].result = -1;
+	free(mark);
+	free(map);
+	free(stack);
+	return root;
+}
+
+void flatten(int node, long i0, long j0, long o, long n, char **grid){
+	if(pool[node].pop == 0)
+		return;
+	if(pool[node].level == 0){
+		//root cell (i0,j0) holds grid cell (i0-o, j0-o)
+		grid[(i0-o+n)%n][(j0-o+n)%n] = 1;
+		return;
+	}
+	long h = 1L << (pool[node].level-1);
+	flatten(pool[node].nw, i0, j0, o, n, grid);
+	flatten(pool[node].ne, i0, j0+h, o, n, grid);
+	flatten(pool[node].sw, i0+h, j0, o, n, grid);
+	flatten(pool[node].se, i0+h, j0+h, o, n, grid);
+}
+
+void updateGrid(char **grid, char **newGrid, int n){
+	for(int i=0; i<n; i++)
+		for(int j=0; j<n; j++){
+			int up = (i-1+n)%n;
+			int down = (i+1)%n;
+			int left = (j-1+n)%n;
+			int right = (j+1)%n;
+			int sumAlive = grid[up][left] + grid[up][j] + grid[up][right] +
+					grid[i][left] + grid[i][right] +
+					grid[down][left] + grid[down][j] + grid[down][right];
+			if(0 == grid[i][j] && 3 == sumAlive)
+				newGrid[i][j] = 1;
+			else if( 1 == grid[i][j] && (2 == sumAlive || 3 == sumAlive))
+				newGrid[i][j] = 1;
+			else
+				newGrid[i][j] = 0;
+		}
+}
+
+char **allocate2D(int n){
+		char *temp = malloc((size_t)n*n*sizeof(char));
+		char **a = malloc(n*sizeof(char *));
+		if(!temp || !a)
+			return NULL;
+		for(int i=0; i<n; i++)
+			a[i] = temp + (size_t)i*n;
+		return a;
+}
@@ -17,16 +17,29 @@
  *
  * -------------------------------------------------------------------
  * Implementation of 2-dimensional k-means algorithm
- * Reads a file of points (with x and y coords on each line)
- * specified in the command line and prompts for number of 
+ * Reads a file of points (with x and y coords on each line, after the
+ * number of points on the first line, or a binary file; see
+ * pointLoader.h) specified in the command line and prompts for number of 
  * clusters and initial guess of each cluster center. 
  * Outputs assignment of each vector to a cluster.
+ * If "hamerly" follows the filename, uses Hamerly's algorithm, which
+ * gives the same assignments but skips most distance calculations.
+ * Each point keeps an upper bound on the distance to its center and
+ * a lower bound on the distance to the second closest center, which
+ * are adjusted by how far centers move in each iteration. A point
+ * can't change cluster if its upper bound is less than its lower bound
+ * or half the distance from its center to the nearest other center.
+ * It uses only 2 bounds per point (Elkan's algorithm uses k), which
+ * works best for low dimensional data. The number of distance
+ * calculations skipped is output to stderr.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 #include <math.h>
+#include "pointLoader.h"
 
 typedef struct{
 	double *x, *y;
@@ -37,6 +50,16 @@ typedef struct{
 void allocVector(Vector *v, int n);
 // Return the index of the closest cluster center to (x,y)
 int findClosest(double x, double y, Vector cluster, int k);
+// distance between (x,y) and cluster center i
+double dist(double x, double y, Vector cluster, int i);
+// k-means using Hamerly's algorithm, with same arguments as
+// variables in main, which have been initialized
+void kmeansHamerly(Vector vector, int n, Vector cluster, Vector clusterNew,
+		int *clusterSize, int *closest, int k);
+
+//relative tolerance of bounds, so rounding errors can't
+//cause a different assignment than findClosest
+#define EPS 1e-9
 
 int main(int argc, char **argv){
 	int n; // number of vectors
@@ -48,30 +71,26 @@ int main(int argc, char **argv){
 	int *closest; //assignment of vectors to cluster centers
 
 	if(argc <2){
-		fprintf(stderr,"usage: %s filename\n", argv[0]);
-		return 1;
-	}
-	FILE *f = fopen(argv[1], "r");
-	if(f == NULL){
-		fprintf(stderr,"can't open file %s\n", argv[1]);
+		fprintf(stderr,"usage: %s filename [hamerly]\n", argv[0]);
 		return 1;
 	}
-	//First line of file should indicate number of points
-	fscanf(f, "%d", &n);
-
 	//Read points and initialize closest
+	long np;
+	double *points = loadPoints(argv[1], 2, &np);
+	if(points == NULL)
+		return 1;
+	n = np;
 	allocVector(&vector, n);
 	if((closest = malloc(n*sizeof(int))) == NULL){
 		fprintf(stderr,"couldn't allocate array of %d ints\n", n);
 		return 1;
 	}
 	for(int i=0; i<n; i++){
-		if(fscanf(f, "%lf %lf", &vector.x[i], &vector.y[i]) != 2){
-			fprintf(stderr,"something wrong with data in file\n");
-			return 1;
-		}
+		vector.x[i] = points[2*i];
+		vector.y[i] = points[2*i+1];
 		closest[i] = 0;
 	}
+	free(points);
 	
 	// Read clusters and initialize cluster arrays
 	printf("enter number of clusters: ");
@@ -94,6 +113,10 @@ int main(int argc, char **argv){
 
 	// k-means
 	bool converged = false;
+	if(argc > 2 && !strcmp(argv[2], "hamerly")){
+		kmeansHamerly(vector, n, cluster, clusterNew, clusterSize, closest, k);
+		converged = true;
+	}
 	while(!converged){
 		converged = true;
 		for(int j=0; j<n; j++){
@@ -140,3 +163,111 @@ int findClosest(double x, double y, Vector cluster, int k){
 	}
 	return mini;
 }
+
+double dist(double x, double y, Vector cluster, int i){
+	return sqrt((x-cluster.x[i])*(x-cluster.x[i]) + (y-cluster.y[i])*(y-cluster.y[i]));
+}
+
+void kmeansHamerly(Vector vector, int n, Vector cluster, Vector clusterNew,
+		int *clusterSize, int *closest, int k){
+	double *upper = malloc(n*sizeof(double)); //bound on distance to center
+	double *lower = malloc(n*sizeof(double)); //bound on 2nd closest
+	double *half = malloc(k*sizeof(double)); //half distance to nearest center
+	double *drift = malloc(k*sizeof(double)); //distance moved by center
+	if(!upper || !lower || !half || !drift){
+		fprintf(stderr,"couldn't allocate memory for bounds\n");
+		exit(1);
+	}
+	for(int j=0; j<n; j++){
+		upper[j] = INFINITY;
+		lower[j] = 0.0;
+	}
+	long long evals = 0; //distance calculations
+	long long total = 0; //distance calculations by findClosest
+	int iter = 0;
+	bool converged = false;
+	while(!converged){
+		converged = true;
+		//an empty cluster's center is NaN, and bounds don't apply
+		bool prune = true;
+		for(int i=0; i<k; i++){
+			if(isnan(cluster.x[i]) || isnan(cluster.y[i]))
+				prune = false;
+			half[i] = INFINITY;
+		}
+		for(int i=0; i<k; i++)
+			for(int i2=i+1; i2<k; i2++){
+				double d = 0.5*dist(cluster.x[i], cluster.y[i], cluster, i2);
+				if(d < half[i])
+					half[i] = d;
+				if(d < half[i2])
+					half[i2] = d;
+			}
+		evals += (long long)k*(k-1)/2;
+		for(int j=0; j<n; j++){
+			double x = vector.x[j], y = vector.y[j];
+			int a = closest[j];
+			double bound = half[a] > lower[j] ? half[a] : lower[j];
+			bound *= 1.0 - EPS;
+			if(prune && upper[j] >= bound){
+				upper[j] = dist(x, y, cluster, a);
+				evals++;
+			}
+			if(!prune || upper[j] >= bound){
+				//same order and comparisons as findClosest
+				double min = dist(x, y, cluster, 0);
+				double second = INFINITY;
+				int mini = 0;
+				for(int i=1; i<k; i++){
+					double d = dist(x, y, cluster, i);
+					if(d < min){
+						second = min;
+						min = d;
+						mini = i;
+					} else if(d < second)
+						second = d;
+				}
+				evals += k;
+				if(mini != a)
+					converged = false;
+				a = closest[j] = mini;
+				upper[j] = min;
+				lower[j] = second;
+			}
+			clusterNew.x[a] += x;
+			clusterNew.y[a] += y;
+			clusterSize[a]++;
+		}
+		total += (long long)n*k;
+		//move centers, and bounds by how far centers moved
+		int far = 0; //center that moved farthest
+		double second = 0.0; //second largest move
+		for(int i=0; i<k; i++){
+			double x = clusterNew.x[i]/clusterSize[i];
+			double y = clusterNew.y[i]/clusterSize[i];
+			drift[i] = dist(x, y, cluster, i);
+			cluster.x[i] = x;
+			cluster.y[i] = y;
+			clusterNew.x[i] = clusterNew.y[i] = 0.0;
+			clusterSize[i] = 0.0;
+			if(drift[i] > drift[far]){
+				second = drift[far];
+				far = i;
+			} else if(i != far && drift[i] > second)
+				second = drift[i];
+		}
+		evals += k;
+		for(int j=0; j<n; j++){
+			int a = closest[j];
+			upper[j] += drift[a];
+			lower[j] -= a == far ? second : drift[far];
+		}
+		iter++;
+	}
+	//center distances and drifts can outnumber savings on small inputs
+	long long saved = total - evals;
+	long long diff = saved < 0 ? -saved : saved;
+	fprintf(stderr,"%d iterations, %lld distance calculations, %lld (%.1f%%) %s than brute force\n",
+			iter, evals, diff, 100.0*diff/total, saved < 0 ? "more" : "fewer");
+	free(upper); free(lower); free(half); free(drift);
+}
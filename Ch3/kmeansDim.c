@@ -0,0 +1,236 @@
+/* Copyright 2017 Eric Aubanel
+ * This file contains code extending Algorithm  3.1 from
+ * Elements of Parallel Computing, by Eric Aubanel, 2016, CRC Press.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------
+ * Implementation of d-dimensional k-means algorithm
+ * Reads a file of points specified in the command line, with the
+ * number of points on the first line, followed by the d coordinates of
+ * each point (d is 2 by default, so files for kmeans.c can be used),
+ * or a binary file (see pointLoader.h).
+ * Prompts for number of clusters and initial guess of each cluster
+ * center as in kmeans.c, unless k is given in the command line, in
+ * which case the first k points are the initial centers.
+ * Outputs assignment of each vector to a cluster, and time of
+ * assignment steps to stderr.
+ * Points are stored by rows (the d coordinates of a point are
+ * contiguous). Squared distances between a block of BP points and a
+ * block of BC centers are computed as |x|^2 + |c|^2 - 2x.c, where the
+ * dot products are computed like a matrix product, with the centers
+ * stored transposed so that the innermost loop, over centers, is
+ * vectorized. Each block of centers fits in cache while it is used
+ * by a block of points. The kernel is compiled separately for d = 2,
+ * so that the loop over coordinates is unrolled.
+ * This form of distance loses accuracy when points are far from the
+ * origin compared to the distance between them, so points that are
+ * almost equally far from 2 centers may be assigned differently than
+ * by kmeans.c.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <sys/time.h>
+#include "pointLoader.h"
+
+#define BP 64 //points per block
+#define BC 64 //centers per block
+
+// assign points [start,start+np) in row layout (stride d) to closest
+// of k centers, stored transposed (ct[t*k+i] is coordinate t of
+// center i), with squared norms cnorm
+void assignBlock(const double *points, int start, int np, int d,
+		const double *ct, const double *cnorm, int k, int *closest);
+// wall clock time in seconds
+double wtime(void);
+
+int main(int argc, char **argv){
+	int n; // number of vectors
+	int d = 2; // dimension
+	int k; // numbef of clusters
+	double *vector; // vectors, row layout
+	double *cluster; // cluster centers, row layout
+	double *clusterT; // cluster centers, transposed
+	double *cnorm; // squared norms of cluster centers
+	double *clusterNew; // for use in calculating new cluster centers
+	int *clusterSize; // array of cluster sizes
+	int *closest; //assignment of vectors to cluster centers
+	int *closestNew; //new assignment
+
+	if(argc <2){
+		fprintf(stderr,"usage: %s filename [d [k]]\n", argv[0]);
+		return 1;
+	}
+	if(argc > 2)
+		d = strtol(argv[2], NULL, 10);
+	if(d < 1){
+		fprintf(stderr,"dimension must be positive\n");
+		return 1;
+	}
+	//Read points and initialize closest
+	long np;
+	vector = loadPoints(argv[1], d, &np);
+	if(vector == NULL)
+		return 1;
+	n = np;
+	closest = malloc(n*sizeof(int));
+	closestNew = malloc(n*sizeof(int));
+	if(!closest || !closestNew){
+		fprintf(stderr,"couldn't allocate memory for %d points\n", n);
+		return 1;
+	}
+	for(int i=0; i<n; i++)
+		closest[i] = 0;
+
+	if(argc > 3){
+		k = strtol(argv[3], NULL, 10);
+		if(k < 1 || k > n){
+			fprintf(stderr,"k must be between 1 and %d\n", n);
+			return 1;
+		}
+	} else{
+		printf("enter number of clusters: ");
+		if(scanf("%d", &k) != 1 || k < 1){
+			fprintf(stderr,"something wrong with number of clusters\n");
+			return 1;
+		}
+	}
+	cluster = malloc((size_t)k*d*sizeof(double));
+	clusterT = malloc((size_t)k*d*sizeof(double));
+	clusterNew = malloc((size_t)k*d*sizeof(double));
+	cnorm = malloc(k*sizeof(double));
+	if((clusterSize = malloc(k*sizeof(int))) == NULL || !cluster
+			|| !clusterT || !clusterNew || !cnorm){
+		fprintf(stderr,"couldn't allocate memory for %d clusters\n", k);
+		return 1;
+	}
+	if(argc > 3)
+		memcpy(cluster, vector, (size_t)k*d*sizeof(double));
+	else{
+		printf("enter coordinates for guess of %d clusters\n", k);
+		for(int i=0; i<k*d; i++){
+			if(scanf("%lf", &cluster[i]) != 1){
+				fprintf(stderr,"something wrong with coordinate\n");
+				return 1;
+			}
+		}
+	}
+	for(int i=0; i<k; i++){
+		for(int t=0; t<d; t++)
+			clusterNew[i*d+t] = 0.0;
+		clusterSize[i] = 0;
+	}
+
+	// k-means
+	double time = 0.0; //time of assignment steps
+	int iter = 0;
+	bool converged = false;
+	while(!converged){
+		converged = true;
+		for(int i=0; i<k; i++){
+			cnorm[i] = 0.0;
+			for(int t=0; t<d; t++){
+				double c = cluster[i*d+t];
+				clusterT[t*k+i] = c;
+				cnorm[i] += c*c;
+			}
+		}
+		double t0 = wtime();
+		for(int j=0; j<n; j+=BP)
+			assignBlock(vector, j, n-j < BP ? n-j : BP, d, clusterT, cnorm, k,
+					closestNew);
+		time += wtime() - t0;
+		for(int j=0; j<n; j++){
+			int i = closestNew[j];
+			if(i != closest[j])
+				converged = false;
+			closest[j] = i;
+			for(int t=0; t<d; t++)
+				clusterNew[i*d+t] += vector[(size_t)j*d+t];
+			clusterSize[i]++;
+		}
+		for(int i=0; i<k; i++){
+			for(int t=0; t<d; t++){
+				cluster[i*d+t] = clusterNew[i*d+t]/clusterSize[i];
+				clusterNew[i*d+t] = 0.0;
+			}
+			clusterSize[i] = 0.0;
+		}
+		iter++;
+	}
+	fprintf(stderr,"%d iterations, assignment time %f s, %f Gflop/s\n",
+			iter, time, 2.0*n*k*d*iter/time*1e-9);
+
+	for(int j=0; j<n; j++)
+		printf("%d\n", closest[j]);
+
+	return 0;
+}
+
+// blocked kernel, inlined into assignBlock for d = 2 and general d
+static inline void assignKernel(const double *points, int start, int np,
+		int d, const double *ct, const double *cnorm, int k, int *closest){
+	double dot[BP][BC]; //dot products of points with block of centers
+	double xnorm[BP];
+	double dmin[BP];
+	const double *x = points + (size_t)start*d;
+	for(int p=0; p<np; p++){
+		xnorm[p] = 0.0;
+		for(int t=0; t<d; t++)
+			xnorm[p] += x[p*d+t]*x[p*d+t];
+		dmin[p] = INFINITY;
+		closest[start+p] = 0;
+	}
+	for(int c0=0; c0<k; c0+=BC){
+		int nc = k-c0 < BC ? k-c0 : BC;
+		for(int p=0; p<np; p++){
+			double *dp = dot[p];
+			for(int c=0; c<nc; c++)
+				dp[c] = 0.0;
+			for(int t=0; t<d; t++){
+				double xt = x[p*d+t];
+				const double *ctt = ct + (size_t)t*k + c0;
+				for(int c=0; c<nc; c++)
+					dp[c] += xt*ctt[c];
+			}
+		}
+		//compare in order of centers, so first of equal distances wins
+		for(int p=0; p<np; p++)
+			for(int c=0; c<nc; c++){
+				double dist = xnorm[p] + cnorm[c0+c] - 2.0*dot[p][c];
+				if(dist < dmin[p] || (c0+c == 0)){
+					dmin[p] = dist;
+					closest[start+p] = c0+c;
+				}
+			}
+	}
+}
+
+void assignBlock(const double *points, int start, int np, int d,
+		const double *ct, const double *cnorm, int k, int *closest){
+	if(2 == d)
+		assignKernel(points, start, np, 2, ct, cnorm, k, closest);
+	else
+		assignKernel(points, start, np, d, ct, cnorm, k, closest);
+}
+
+double wtime(void){
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec*1e-6;
+}
@@ -0,0 +1,393 @@
+/* Copyright 2017 Eric Aubanel
+ * This file contains code extending Algorithm  3.1 from
+ * Elements of Parallel Computing, by Eric Aubanel, 2016, CRC Press.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------
+ * Streaming 2-dimensional k-means, for point sets that don't fit in
+ * memory, using mini-batch updates (Sculley, Web-scale k-means
+ * clustering, 2010).
+ * Points are read from a binary file, which is memory mapped and
+ * processed in chunks of CHUNK points, so only a few chunks need to
+ * be in memory at once. The file format is described in pointLoader.h,
+ * with points of dimension 2 and coordinates of type double.
+ * kmeansStream -c textFile binaryFile converts a text file (such as a
+ * file for kmeans.c) to this format.
+ * The file is divided into batches of consecutive points. Each point
+ * of a batch is assigned to its closest center, then each center is
+ * moved towards its points, with a step size of 1/(number of points
+ * it has been assigned so far). This is repeated for each batch, for
+ * the given number of passes (epochs) through the file.
+ * If k is given, initial centers are chosen by k-means|| (Bahmani et
+ * al., Scalable k-means++, 2012): starting from a random point, in
+ * each of ROUNDS passes points are sampled with probability
+ * proportional to their squared distance from the centers so far,
+ * with 2k expected samples per pass. The samples, weighted by how many
+ * points are closest to them, are then reduced to k centers by
+ * k-means++ and weighted k-means. Otherwise prompts for k and centers
+ * as in kmeans.c.
+ * Outputs final centers, and to stderr the time and points/s of each
+ * phase and the mean squared distance of points from their centers.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include "pointLoader.h"
+
+#define CHUNK 65536 //points per chunk
+#define ROUNDS 5 //k-means|| sampling rounds
+#define LLOYD_ITER 20 //weighted k-means iterations on samples
+
+typedef struct{
+	double *x, *y;
+} Vector;
+
+typedef struct{
+	const double *p; //coordinates, x and y of each point
+	long n; //number of points
+	void *map; //mapped file
+	size_t size;
+} PointFile;
+
+// allocate struct of 2 arrays of doubles of length n
+void allocVector(Vector *v, int n);
+// Return the index of the closest cluster center to (x,y), and its
+// squared distance in dmin
+int findClosest(double x, double y, Vector cluster, int k, double *dmin);
+// memory map binary point file, returns 0 if successful
+int openPoints(const char *name, PointFile *pf);
+// convert text file (see pointLoader.h) to binary file
+int convert(const char *textName, const char *binName);
+// tell OS that points [start, start+len) will be needed soon, and
+// points before start won't be needed again
+void advise(PointFile pf, long start, long len);
+// choose k initial centers by k-means||
+void seedParallel(PointFile pf, Vector cluster, int k);
+// mini-batch k-means with given batch size and number of passes
+void miniBatch(PointFile pf, Vector cluster, int k, long batch, int epochs);
+// mean squared distance of points from closest center
+double meanCost(PointFile pf, Vector cluster, int k);
+// uniform random number in [0,1)
+double uniform(void);
+// wall clock time in seconds
+double wtime(void);
+
+int main(int argc, char **argv){
+	int k; // number of clusters
+	Vector cluster; // cluster centers
+	PointFile pf;
+
+	if(argc == 4 && !strcmp(argv[1], "-c"))
+		return convert(argv[2], argv[3]);
+	if(argc <4){
+		fprintf(stderr,"usage: %s filename batch epochs [k [seed]]\n", argv[0]);
+		fprintf(stderr,"       %s -c textFile binaryFile\n", argv[0]);
+		return 1;
+	}
+	if(openPoints(argv[1], &pf))
+		return 1;
+	long batch = strtol(argv[2], NULL, 10);
+	int epochs = strtol(argv[3], NULL, 10);
+	if(batch < 1 || epochs < 1){
+		fprintf(stderr,"batch and epochs must be positive\n");
+		return 1;
+	}
+
+	double time;
+	if(argc > 4){
+		k = strtol(argv[4], NULL, 10);
+		if(k < 1 || k > pf.n){
+			fprintf(stderr,"k must be between 1 and %ld\n", pf.n);
+			return 1;
+		}
+		srand(argc > 5 ? strtol(argv[5], NULL, 10) : 1);
+		allocVector(&cluster, k);
+		time = wtime();
+		seedParallel(pf, cluster, k);
+		time = wtime() - time;
+		fprintf(stderr,"k-means|| seeding: %f s, %e points/s\n", time,
+				(double)(2*ROUNDS+1)*pf.n/time);
+	} else{
+		printf("enter number of clusters: ");
+		if(scanf("%d", &k) != 1 || k < 1){
+			fprintf(stderr,"something wrong with number of clusters\n");
+			return 1;
+		}
+		allocVector(&cluster, k);
+		printf("enter coordinates for guess of %d clusters\n", k);
+		for(int i=0; i<k; i++){
+			if(scanf("%lf %lf", &cluster.x[i], &cluster.y[i]) != 2){
+				fprintf(stderr,"something wrong with coordinate\n");
+				return 1;
+			}
+		}
+	}
+
+	time = wtime();
+	miniBatch(pf, cluster, k, batch, epochs);
+	time = wtime() - time;
+	fprintf(stderr,"mini-batch k-means: %f s, %e points/s\n", time,
+			(double)epochs*pf.n/time);
+	time = wtime();
+	double cost = meanCost(pf, cluster, k);
+	time = wtime() - time;
+	fprintf(stderr,"mean squared distance %e: %f s, %e points/s\n", cost,
+			time, pf.n/time);
+
+	for(int i=0; i<k; i++)
+		printf("%f %f\n", cluster.x[i], cluster.y[i]);
+	munmap(pf.map, pf.size);
+	return 0;
+}
+
+void allocVector(Vector *v, int n){
+	v->x = malloc(n*sizeof(double));
+	v->y = malloc(n*sizeof(double));
+	if(v->x == NULL || v->y == NULL){
+		fprintf(stderr,"couldn't allocate memory for %d doubles\n", n);
+		exit(1);
+	}
+}
+
+int findClosest(double x, double y, Vector cluster, int k, double *dmin){
+	double min = (x-cluster.x[0])*(x-cluster.x[0]) + (y-cluster.y[0])*(y-cluster.y[0]);
+	int mini = 0;
+	for(int i=1; i<k; i++){
+		double d = (x-cluster.x[i])*(x-cluster.x[i]) + (y-cluster.y[i])*(y-cluster.y[i]);
+		if(d < min){
+			min = d;
+			mini = i;
+		}
+	}
+	*dmin = min;
+	return mini;
+}
+
+int openPoints(const char *name, PointFile *pf){
+	PointHeader h;
+	pf->p = mapPoints(name, &h);
+	if(pf->p == NULL || h.dim != 2 || h.type != POINT_DOUBLE){
+		fprintf(stderr,"%s isn't a binary file of 2D points of type double\n",
+				name);
+		return 1;
+	}
+	pf->map = (char *)pf->p - sizeof(h);
+	pf->size = sizeof(h) + h.count*2*sizeof(double);
+	pf->n = h.count;
+	return 0;
+}
+
+int convert(const char *textName, const char *binName){
+	long n;
+	double *p = loadPoints(textName, 2, &n);
+	if(p == NULL)
+		return 1;
+	int r = savePoints(binName, p, n, 2, POINT_DOUBLE);
+	free(p);
+	return r;
+}
+
+void advise(PointFile pf, long start, long len){
+	long page = sysconf(_SC_PAGESIZE);
+	char *base = (char *)pf.map;
+	long end = start+len < pf.n ? start+len : pf.n;
+	long prev = start-len < 0 ? 0 : start-len;
+	//offsets in file, rounded down to start of page
+	long from = ((char *)(pf.p + 2*start) - base)/page*page;
+	long to = (char *)(pf.p + 2*end) - base;
+	long prevFrom = ((char *)(pf.p + 2*prev) - base)/page*page;
+	madvise(base + from, to - from, MADV_WILLNEED);
+	if(from > prevFrom)
+		madvise(base + prevFrom, from - prevFrom, MADV_DONTNEED);
+}
+
+double uniform(void){
+	return rand()/(RAND_MAX + 1.0);
+}
+
+void seedParallel(PointFile pf, Vector cluster, int k){
+	int cap = 2*k*ROUNDS + 1; //capacity of samples, grown if needed
+	Vector cand;
+	allocVector(&cand, cap);
+	long first = (long)(uniform()*pf.n);
+	cand.x[0] = pf.p[2*first];
+	cand.y[0] = pf.p[2*first+1];
+	int m = 1; //number of samples
+	double over = 2.0*k; //expected samples per round
+	for(int r=0; r<ROUNDS; r++){
+		double cost = 0.0;
+		for(long c=0; c<pf.n; c+=CHUNK){
+			advise(pf, c, CHUNK);
+			for(long j=c; j<c+CHUNK && j<pf.n; j++){
+				double d;
+				findClosest(pf.p[2*j], pf.p[2*j+1], cand, m, &d);
+				cost += d;
+			}
+		}
+		if(cost == 0.0)
+			break;
+		int mOld = m;
+		for(long c=0; c<pf.n; c+=CHUNK){
+			advise(pf, c, CHUNK);
+			for(long j=c; j<c+CHUNK && j<pf.n; j++){
+				double d;
+				findClosest(pf.p[2*j], pf.p[2*j+1], cand, mOld, &d);
+				if(uniform() < over*d/cost){
+					if(m == cap){
+						cap *= 2;
+						cand.x = realloc(cand.x, cap*sizeof(double));
+						cand.y = realloc(cand.y, cap*sizeof(double));
+						if(!cand.x || !cand.y){
+							fprintf(stderr,"couldn't allocate memory for samples\n");
+							exit(1);
+						}
+					}
+					cand.x[m] = pf.p[2*j];
+					cand.y[m] = pf.p[2*j+1];
+					m++;
+				}
+			}
+		}
+	}
+
+	//weight of each sample is number of points closest to it
+	double *w = calloc(m, sizeof(double));
+	double *d2 = malloc(m*sizeof(double));
+	int *closest = malloc(m*sizeof(int));
+	if(!w || !d2 || !closest){
+		fprintf(stderr,"couldn't allocate memory for samples\n");
+		exit(1);
+	}
+	for(long c=0; c<pf.n; c+=CHUNK){
+		advise(pf, c, CHUNK);
+		for(long j=c; j<c+CHUNK && j<pf.n; j++){
+			double d;
+			w[findClosest(pf.p[2*j], pf.p[2*j+1], cand, m, &d)] += 1.0;
+		}
+	}
+
+	//weighted k-means++ on samples
+	int pick = 0;
+	for(int i=0; i<k; i++){
+		if(i > 0){
+			double total = 0.0;
+			for(int s=0; s<m; s++){
+				findClosest(cand.x[s], cand.y[s], cluster, i, &d2[s]);
+				total += w[s]*d2[s];
+			}
+			//if all samples are centers, pick any
+			pick = (int)(uniform()*m);
+			double target = uniform()*total;
+			for(int s=0; s<m && total > 0.0; s++){
+				target -= w[s]*d2[s];
+				if(target < 0.0 && w[s]*d2[s] > 0.0){
+					pick = s;
+					break;
+				}
+			}
+		}
+		cluster.x[i] = cand.x[pick];
+		cluster.y[i] = cand.y[pick];
+	}
+
+	//weighted k-means on samples
+	Vector clusterNew;
+	allocVector(&clusterNew, k);
+	double *weight = malloc(k*sizeof(double));
+	if(!weight){
+		fprintf(stderr,"couldn't allocate memory for samples\n");
+		exit(1);
+	}
+	for(int s=0; s<m; s++)
+		closest[s] = -1;
+	for(int it=0; it<LLOYD_ITER; it++){
+		int changed = 0;
+		for(int i=0; i<k; i++){
+			clusterNew.x[i] = clusterNew.y[i] = 0.0;
+			weight[i] = 0.0;
+		}
+		for(int s=0; s<m; s++){
+			double d;
+			int i = findClosest(cand.x[s], cand.y[s], cluster, k, &d);
+			changed += i != closest[s];
+			closest[s] = i;
+			clusterNew.x[i] += w[s]*cand.x[s];
+			clusterNew.y[i] += w[s]*cand.y[s];
+			weight[i] += w[s];
+		}
+		if(!changed)
+			break;
+		//a center without samples stays where it is
+		for(int i=0; i<k; i++)
+			if(weight[i] > 0.0){
+				cluster.x[i] = clusterNew.x[i]/weight[i];
+				cluster.y[i] = clusterNew.y[i]/weight[i];
+			}
+	}
+	free(cand.x); free(cand.y); free(clusterNew.x); free(clusterNew.y);
+	free(w); free(d2); free(closest); free(weight);
+}
+
+void miniBatch(PointFile pf, Vector cluster, int k, long batch, int epochs){
+	long *count = calloc(k, sizeof(long)); //points assigned to each center
+	int *closest = malloc(batch*sizeof(int)); //assignment of batch
+	if(!count || !closest){
+		fprintf(stderr,"couldn't allocate memory for batch\n");
+		exit(1);
+	}
+	for(int e=0; e<epochs; e++)
+		for(long b=0; b<pf.n; b+=batch){
+			long len = pf.n-b < batch ? pf.n-b : batch;
+			const double *p = pf.p + 2*b;
+			advise(pf, b, len > CHUNK ? len : CHUNK);
+			//assign batch to centers, then move centers
+			for(long j=0; j<len; j++){
+				double d;
+				closest[j] = findClosest(p[2*j], p[2*j+1], cluster, k, &d);
+			}
+			for(long j=0; j<len; j++){
+				int i = closest[j];
+				double eta = 1.0/++count[i];
+				cluster.x[i] += eta*(p[2*j] - cluster.x[i]);
+				cluster.y[i] += eta*(p[2*j+1] - cluster.y[i]);
+			}
+		}
+	free(count);
+	free(closest);
+}
+
+double meanCost(PointFile pf, Vector cluster, int k){
+	double cost = 0.0;
+	for(long c=0; c<pf.n; c+=CHUNK){
+		advise(pf, c, CHUNK);
+		for(long j=c; j<c+CHUNK && j<pf.n; j++){
+			double d;
+			findClosest(pf.p[2*j], pf.p[2*j+1], cluster, k, &d);
+			cost += d;
+		}
+	}
+	return cost/pf.n;
+}
+
+double wtime(void){
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec*1e-6;
+}
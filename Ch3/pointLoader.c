@@ -0,0 +1,293 @@
+// Implementation of loader for files of points (see pointLoader.h).
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "pointLoader.h"
+
+#define MAX_THREADS 256
+
+// size in bytes of coordinate of given type, 0 if unknown
+size_t typeSize(uint32_t type);
+// converts n*d coordinates of given type to doubles
+double *toDouble(const void *coords, uint32_t type, long nd);
+// reads entire file (stdin if name is "-") into NUL terminated
+// buffer, returns buffer and its length in len, or NULL if error
+char *readAll(const char *name, size_t *len);
+// converts number at s, like strtod
+double parseNumber(const char *s, char **end);
+// parses coordinates of points with d coordinates in text buf of
+// length len, returns array of coordinates and n, or NULL if error
+double *parseText(const char *buf, size_t len, int d, long *n);
+
+size_t typeSize(uint32_t type){
+	switch(type){
+		case POINT_DOUBLE: return sizeof(double);
+		case POINT_FLOAT: return sizeof(float);
+		case POINT_INT32: return sizeof(int32_t);
+		default: return 0;
+	}
+}
+
+const void *mapPoints(const char *name, PointHeader *h){
+	int fd = open(name, O_RDONLY);
+	struct stat st;
+	if(fd < 0)
+		return NULL;
+	if(fstat(fd, &st) || st.st_size < (off_t)sizeof(*h)
+			|| read(fd, h, sizeof(*h)) != sizeof(*h) || h->magic != POINT_MAGIC
+			|| !typeSize(h->type) || st.st_size < (off_t)(sizeof(*h)
+			+ h->count*h->dim*typeSize(h->type))){
+		close(fd);
+		return NULL;
+	}
+	void *map = mmap(NULL, sizeof(*h) + h->count*h->dim*typeSize(h->type),
+			PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(map == MAP_FAILED)
+		return NULL;
+	madvise(map, sizeof(*h) + h->count*h->dim*typeSize(h->type),
+			MADV_SEQUENTIAL);
+	return (char *)map + sizeof(*h);
+}
+
+void unmapPoints(const void *coords, const PointHeader *h){
+	munmap((char *)coords - sizeof(*h),
+			sizeof(*h) + h->count*h->dim*typeSize(h->type));
+}
+
+double *toDouble(const void *coords, uint32_t type, long nd){
+	double *a = malloc((nd > 0 ? nd : 1)*sizeof(double));
+	if(!a)
+		return NULL;
+	#pragma omp parallel for
+	for(long i=0; i<nd; i++)
+		switch(type){
+			case POINT_DOUBLE: a[i] = ((const double *)coords)[i]; break;
+			case POINT_FLOAT: a[i] = ((const float *)coords)[i]; break;
+			case POINT_INT32: a[i] = ((const int32_t *)coords)[i]; break;
+		}
+	return a;
+}
+
+char *readAll(const char *name, size_t *len){
+	FILE *f = strcmp(name, "-") ? fopen(name, "rb") : stdin;
+	if(f == NULL)
+		return NULL;
+	size_t cap = 1 << 20;
+	char *buf = malloc(cap);
+	*len = 0;
+	size_t r;
+	while(buf && (r = fread(buf + *len, 1, cap - *len - 1, f)) > 0){
+		*len += r;
+		if(*len == cap - 1){
+			cap *= 2;
+			char *b = realloc(buf, cap);
+			if(!b)
+				free(buf);
+			buf = b;
+		}
+	}
+	if(f != stdin)
+		fclose(f);
+	if(buf)
+		buf[*len] = '\0';
+	return buf;
+}
+
+double parseNumber(const char *s, char **end){
+	//powers of 10 that are exact doubles
+	static const double pow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+			1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+			1e20, 1e21, 1e22};
+	const char *c = s;
+	int neg = *c == '-';
+	if(*c == '-' || *c == '+')
+		c++;
+	uint64_t m = 0; //digits as integer
+	int digits = 0, frac = 0;
+	for(; *c >= '0' && *c <= '9'; c++, digits++)
+		m = 10*m + (*c - '0');
+	if(*c == '.')
+		for(c++; *c >= '0' && *c <= '9'; c++, digits++, frac++)
+			m = 10*m + (*c - '0');
+	//m and 10^frac are exact, so the quotient is correctly rounded,
+	//otherwise (exponent, too many digits, ...) use strtod
+	if(digits == 0 || digits > 15 || frac > 22 || *c == 'e' || *c == 'E')
+		return strtod(s, end);
+	*end = (char *)c;
+	double x = m/pow10[frac];
+	return neg ? -x : x;
+}
+
+//separator between coordinates
+#define IS_SEP(c) ((c) == ',' || (c) == ' ' || (c) == '\n' || (c) == '\t' \
+		|| (c) == '\r')
+
+double *parseText(const char *buf, size_t len, int d, long *n){
+	int nt = 1;
+	#ifdef _OPENMP
+	nt = omp_get_max_threads();
+	#endif
+	if(nt > MAX_THREADS)
+		nt = MAX_THREADS;
+	//chunk t is [start[t], start[t+1]), which start at separators,
+	//so no number is split between chunks
+	size_t start[MAX_THREADS+1];
+	long count[MAX_THREADS+1]; //numbers in chunks before chunk t
+	start[0] = 0;
+	start[nt] = len;
+	for(int t=1; t<nt; t++){
+		size_t s = len/nt*t;
+		if(s < start[t-1])
+			s = start[t-1];
+		while(s < len && !IS_SEP(buf[s]))
+			s++;
+		start[t] = s;
+	}
+	count[0] = 0;
+	#pragma omp parallel for num_threads(nt)
+	for(int t=0; t<nt; t++){
+		long c = 0;
+		for(size_t i=start[t]; i<start[t+1]; i++)
+			if(!IS_SEP(buf[i]) && (i == 0 || IS_SEP(buf[i-1])))
+				c++;
+		count[t+1] = c;
+	}
+	for(int t=0; t<nt; t++)
+		count[t+1] += count[t];
+	long total = count[nt];
+	double *a = malloc((total > 0 ? total : 1)*sizeof(double));
+	if(!a){
+		fprintf(stderr,"couldn't allocate memory for %ld numbers\n", total);
+		return NULL;
+	}
+	int error = 0;
+	#pragma omp parallel for num_threads(nt) reduction(|:error)
+	for(int t=0; t<nt; t++){
+		long j = count[t];
+		const char *s = buf + start[t], *end = buf + start[t+1];
+		while(s < end){
+			if(IS_SEP(*s)){
+				s++;
+				continue;
+			}
+			char *e;
+			a[j++] = parseNumber(s, &e);
+			//number must be followed by separator or end of file
+			if(e == s || (*e != '\0' && !IS_SEP(*e))){
+				error = 1;
+				break;
+			}
+			s = e;
+		}
+	}
+	if(error || d < 1){
+		fprintf(stderr,"something wrong with data in file\n");
+		free(a);
+		return NULL;
+	}
+	//number of points may be first number in file
+	if(d > 1 && total % d == 1){
+		if(a[0] != (total-1)/d){
+			fprintf(stderr,"number of points in file is %ld, not %.0f\n",
+					(total-1)/d, a[0]);
+			free(a);
+			return NULL;
+		}
+		memmove(a, a+1, (total-1)*sizeof(double));
+		total--;
+	}
+	if(total % d){
+		fprintf(stderr,"number of coordinates in file isn't divisible by %d\n", d);
+		free(a);
+		return NULL;
+	}
+	*n = total/d;
+	return a;
+}
+
+double *loadPoints(const char *name, int d, long *n){
+	PointHeader h;
+	const void *coords = strcmp(name, "-") ? mapPoints(name, &h) : NULL;
+	if(coords){
+		double *a = NULL;
+		if(h.dim != (uint32_t)d)
+			fprintf(stderr,"%s has points of dimension %u, not %d\n", name,
+					h.dim, d);
+		else if(!(a = toDouble(coords, h.type, h.count*d)))
+			fprintf(stderr,"couldn't allocate memory for %lu points\n",
+					(unsigned long)h.count);
+		*n = h.count;
+		unmapPoints(coords, &h);
+		return a;
+	}
+	size_t len;
+	char *buf = readAll(name, &len);
+	if(!buf){
+		fprintf(stderr,"can't read file %s\n", name);
+		return NULL;
+	}
+	double *a = NULL;
+	if(len >= sizeof(h) && ((PointHeader *)buf)->magic == POINT_MAGIC){
+		//binary file from stdin
+		memcpy(&h, buf, sizeof(h));
+		if(h.dim != (uint32_t)d || !typeSize(h.type)
+				|| len < sizeof(h) + h.count*d*typeSize(h.type))
+			fprintf(stderr,"something wrong with binary points in %s\n", name);
+		else if(!(a = toDouble(buf + sizeof(h), h.type, h.count*d)))
+			fprintf(stderr,"couldn't allocate memory for %lu points\n",
+					(unsigned long)h.count);
+		*n = h.count;
+	} else
+		a = parseText(buf, len, d, n);
+	free(buf);
+	return a;
+}
+
+int *loadPointsInt(const char *name, int d, long *n){
+	double *a = loadPoints(name, d, n);
+	if(!a)
+		return NULL;
+	int *b = malloc((*n*d > 0 ? *n*d : 1)*sizeof(int));
+	if(!b)
+		fprintf(stderr,"couldn't allocate memory for %ld points\n", *n);
+	else
+		for(long i=0; i<*n*d; i++)
+			b[i] = lround(a[i]);
+	free(a);
+	return b;
+}
+
+int savePoints(const char *name, const double *coords, long n, int d,
+		enum PointType type){
+	FILE *f = fopen(name, "wb");
+	if(f == NULL){
+		fprintf(stderr,"can't open file %s\n", name);
+		return 1;
+	}
+	PointHeader h = {POINT_MAGIC, d, type, 0, n};
+	fwrite(&h, sizeof(h), 1, f);
+	for(long i=0; i<n*d; i++){
+		double x = coords[i];
+		float y = x;
+		int32_t z = lround(x);
+		switch(type){
+			case POINT_DOUBLE: fwrite(&x, sizeof(x), 1, f); break;
+			case POINT_FLOAT: fwrite(&y, sizeof(y), 1, f); break;
+			case POINT_INT32: fwrite(&z, sizeof(z), 1, f); break;
+		}
+	}
+	if(fclose(f)){
+		fprintf(stderr,"couldn't write file %s\n", name);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,36 @@
+// Loader for files of points, used by programs in Chapters 3 and 8.
+// Binary files have a header, followed by count points with dim
+// coordinates each, of the given type. They are memory mapped.
+// Text files have coordinates separated by whitespace and/or commas
+// (so both "x y" and "x,y" lines can be read), optionally preceded by
+// the number of points. They are parsed in parallel if compiled with
+// OpenMP (number of threads set by OMP_NUM_THREADS).
+#ifndef POINTLOADER_H
+#define POINTLOADER_H
+#include <stdint.h>
+#define POINT_MAGIC 0x31535450 //"PTS1"
+// type of coordinates in binary file
+enum PointType {POINT_DOUBLE, POINT_FLOAT, POINT_INT32};
+typedef struct{
+	uint32_t magic;
+	uint32_t dim; //coordinates per point
+	uint32_t type; //PointType
+	uint32_t pad;
+	uint64_t count; //number of points
+} PointHeader;
+// memory maps binary point file, stores its header in h and returns
+// pointer to first coordinate, or NULL if it isn't a binary point file
+const void *mapPoints(const char *name, PointHeader *h);
+// unmaps file mapped by mapPoints
+void unmapPoints(const void *coords, const PointHeader *h);
+// loads points with d coordinates from binary or text file (stdin if
+// name is "-"). Returns array of n*d coordinates (of point 0, then
+// point 1, ...), and n, or NULL if error (message written to stderr)
+double *loadPoints(const char *name, int d, long *n);
+// same as loadPoints, with coordinates rounded to ints
+int *loadPointsInt(const char *name, int d, long *n);
+// writes n points with d coordinates to binary file with coordinates
+// of given type, returns 0 if successful
+int savePoints(const char *name, const double *coords, long n, int d,
+		enum PointType type);
+#endif
@@ -0,0 +1,118 @@
+// Implementation of autotuning of recursion cutoffs (see cutoffTuner.h).
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "cutoffTuner.h"
+
+#define MIN_CUTOFF 16 //smallest cutoff tried
+#define REPS 3 //trials of each cutoff, minimum time used
+
+// writes name of profile file into buf of length len
+void profileName(char *buf, size_t len);
+// index of highest bit of n, so sizes within a power of 2 share entries
+int sizeClass(long n);
+// minimum time per element in ns of REPS trials with cutoff
+double timeTrial(CutoffTrial trial, long n, int cutoff);
+// cutoff limited to give at least LEAVES_PER_WORKER leaves per worker
+// for inputs larger than trials
+int clampCutoff(int cutoff, long n, int nw);
+
+void profileName(char *buf, size_t len){
+	const char *env = getenv("CUTOFF_PROFILE");
+	if(env){
+		snprintf(buf, len, "%s", env);
+		return;
+	}
+	char host[256];
+	if(gethostname(host, sizeof(host)))
+		strcpy(host, "unknown");
+	host[sizeof(host)-1] = '\0';
+	const char *home = getenv("HOME");
+	snprintf(buf, len, "%s/.cutoffs.%s", home ? home : ".", host);
+}
+
+int sizeClass(long n){
+	int c = 0;
+	while(n >>= 1)
+		c++;
+	return c;
+}
+
+double timeTrial(CutoffTrial trial, long n, int cutoff){
+	double best = 0;
+	for(int r=0; r<REPS; r++){
+		double t = trial(n, cutoff);
+		if(r == 0 || t < best)
+			best = t;
+	}
+	return best/n*1e9;
+}
+
+int clampCutoff(int cutoff, long n, int nw){
+	long max = n/(LEAVES_PER_WORKER*(long)nw);
+	if(n > TRIAL_N && cutoff > max)
+		cutoff = max;
+	return cutoff;
+}
+
+int tuneCutoff(const char *name, long n, int nw, CutoffTrial trial){
+	char file[4096];
+	profileName(file, sizeof(file));
+	long nt = n < TRIAL_N ? n : TRIAL_N; //size of trials
+	//keyed on trial size, as all larger inputs get the same calibration
+	int size = sizeClass(nt);
+	int cutoff = 0;
+	FILE *f = fopen(file, "r");
+	if(f){
+		//program workers sizeClass cutoff ns/element, last entry is used
+		char pname[64];
+		int pnw, psize, pcutoff;
+		double pns;
+		while(fscanf(f, "%63s %d %d %d %lf", pname, &pnw, &psize, &pcutoff,
+				&pns) == 5)
+			if(!strcmp(pname, name) && pnw == nw && psize == size)
+				cutoff = pcutoff;
+		fclose(f);
+	}
+	if(cutoff > 0){
+		cutoff = clampCutoff(cutoff, n, nw);
+		printf("cutoff %d from %s\n", cutoff, file);
+		return cutoff;
+	}
+
+	//cutoffs MIN_CUTOFF*4^j, up to nt/nw, so trials fork across all workers
+	long maxCutoff = nt/nw > MIN_CUTOFF ? nt/nw : MIN_CUTOFF;
+	double best = 0;
+	for(long c=MIN_CUTOFF; c<=maxCutoff; c*=4){
+		double t = timeTrial(trial, nt, c);
+		if(cutoff == 0 || t < best){
+			best = t;
+			cutoff = c;
+		}
+	}
+	//refine with cutoffs half and twice the best one
+	long c[2] = {cutoff/2, (long)cutoff*2};
+	for(int i=0; i<2; i++)
+		if(c[i] >= MIN_CUTOFF && c[i] <= maxCutoff){
+			double t = timeTrial(trial, nt, c[i]);
+			if(t < best){
+				best = t;
+				cutoff = c[i];
+			}
+		}
+	int saved = 0;
+	f = fopen(file, "a");
+	if(f){
+		fprintf(f, "%s %d %d %d %f\n", name, nw, size, cutoff, best);
+		fclose(f);
+		saved = 1;
+	}
+	printf("cutoff %d (%.2f ns per element) from calibration, %s %s\n",
+			cutoff, best, saved ? "saved in" : "can't save in", file);
+	int c0 = cutoff;
+	cutoff = clampCutoff(cutoff, n, nw);
+	if(cutoff != c0)
+		printf("cutoff %d for input size %ld\n", cutoff, n);
+	return cutoff;
+}
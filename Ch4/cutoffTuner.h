@@ -0,0 +1,25 @@
+// Autotuning of the recursion cutoff (grain size) of fork-join programs,
+// used by piEstimate.c, piForkJoin.c and mergeSortForkJoin.c.
+// The best cutoff depends on the machine, the number of workers and the
+// input size, so it is found by short calibration trials: the program
+// is timed for a range of cutoffs on an input of up to TRIAL_N elements,
+// and the cutoff with the lowest time per element is chosen. Cutoffs are
+// at most the trial size over the number of workers, so every trial
+// forks across all workers. The result is saved in a profile file for
+// the host, $HOME/.cutoffs.<hostname> (or the file named by environment
+// variable CUTOFF_PROFILE), so later runs with the same program, number
+// of workers and trial size (input size up to TRIAL_N, to within a power
+// of 2, so all larger inputs share one entry) use it without calibration.
+// Delete the file to calibrate again. For inputs larger than TRIAL_N the
+// cutoff is reduced if needed to give at least LEAVES_PER_WORKER leaves
+// (calls that don't recurse) per worker.
+#ifndef CUTOFFTUNER_H
+#define CUTOFFTUNER_H
+#define TRIAL_N (1 << 18) //maximum input size of calibration trials
+#define LEAVES_PER_WORKER 8 //minimum for inputs larger than TRIAL_N
+// runs program with input of size n and given cutoff, returns time in s
+typedef double (*CutoffTrial)(long n, int cutoff);
+// returns cutoff for program name with input of size n and nw workers,
+// from profile file, or from calibration with trial (and saved in file)
+int tuneCutoff(const char *name, long n, int nw, CutoffTrial trial);
+#endif
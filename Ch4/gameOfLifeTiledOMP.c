@@ -0,0 +1,241 @@
+/* Copyright 2017 Eric Aubanel
+ * This file contains code extending Algorithm  3.5 from
+ * Elements of Parallel Computing, by Eric Aubanel, 2016, CRC Press.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------
+ * Conway's Game of Life, with periodic boundary conditions, using
+ * temporal blocking: K generations are advanced in each pass over the
+ * grid, instead of streaming the whole grid through memory every
+ * generation.
+ * The grid is divided into tile x tile blocks. For each block a
+ * (tile+2K) x (tile+2K) region (the block plus a halo K cells wide) is
+ * copied into a small local array, which is then updated K times. The
+ * region that is valid shrinks by one cell on each side per generation
+ * (a trapezoid in space-time), so after K generations the block itself
+ * is correct and is copied to newGrid. Halo cells are computed
+ * redundantly by neighbouring blocks, so blocks are independent, and
+ * are distributed among OpenMP threads.
+ * The sequential updateGrid from gameOfLife.c is used as the reference:
+ * it is timed with 1 thread, then the tiled version with 1 thread (the
+ * sequential tiled sweep) and with all threads, and results are checked.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <omp.h>
+
+//reference sequential update of grid, from gameOfLife.c
+void updateGrid(char **grid, char **newGrid, int n);
+//advance K generations from grid into newGrid, using tile x tile blocks
+//with nt threads; work holds 2 local arrays of (tile+2K)^2 chars per thread
+void updateGridTiled(char **grid, char **newGrid, int n, int K, int tile,
+		char *work, int nt);
+//one generation of local array a into b, for rows [lo..hi) and
+//columns [lo..hj) of an array with L columns
+void updateLocal(char *a, char *b, int L, int lo, int hi, int hj);
+char **initialize(int seed, int n);
+char **allocate2D(int n);
+
+int main(int argc, char **argv){
+	int n; // n x n grid
+	int ngen; // number of generations
+	int K; // generations per pass
+	int tile = 128; // width of square block
+	char **grid; // Game grid
+	char **newGrid; //copy of grid
+	char **grid0; //initial grid
+	char **ref; //result of reference version
+	struct timespec tstart,tend;
+	double timer;
+
+	if(argc <4){
+		fprintf(stderr,"usage: %s n ngen K [tile] [seed]\n", argv[0]);
+		return 1;
+	}
+	n = strtol(argv[1], NULL, 10);
+	ngen = strtol(argv[2], NULL, 10);
+	K = strtol(argv[3], NULL, 10);
+	if(argc > 4)
+		tile = strtol(argv[4], NULL, 10);
+	int seed;
+	if(6 == argc)
+		seed = strtol(argv[5], NULL, 10);
+	else
+		seed = -1;
+	if(K < 1 || tile < 1){
+		fprintf(stderr,"K and tile must be positive\n");
+		return 1;
+	}
+	int nt = omp_get_max_threads();
+	int L = tile + 2*K;
+	grid0 = initialize(seed, n);
+	grid = allocate2D(n);
+	newGrid = allocate2D(n);
+	char *work = malloc((size_t)2*L*L*nt);
+	if(!grid0 || !grid || !newGrid || !work){
+		fprintf(stderr,"couldn't allocate memory for grid\n");
+		return 1;
+	}
+	double cells = (double)n*n*ngen;
+
+	//reference version
+	memcpy(grid[0], grid0[0], (size_t)n*n);
+	clock_gettime(CLOCK_MONOTONIC, &tstart);
+	for(int k=0; k<ngen; k++){
+		updateGrid(grid, newGrid, n);
+		char ** temp = grid;
+		grid = newGrid;
+		newGrid = temp;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &tend);
+  timer = (tend.tv_sec-tstart.tv_sec) +
+        (tend.tv_nsec-tstart.tv_nsec)*1.0e-9;
+	printf("sequential time in s: %f (%.1f Mcell-updates/s)\n", timer,
+			cells/timer*1e-6);
+	ref = grid;
+	grid = allocate2D(n);
+	if(!grid){
+		fprintf(stderr,"couldn't allocate memory for grid\n");
+		return 1;
+	}
+
+	int threads[] = {1, nt};
+	int passed = 1;
+	for(int t=0; t<2; t++){
+		if(t && nt == 1)
+			break;
+		memcpy(grid[0], grid0[0], (size_t)n*n);
+		clock_gettime(CLOCK_MONOTONIC, &tstart);
+		for(int k=0; k<ngen; k+=K){
+			int steps = (ngen-k < K) ? ngen-k : K;
+			updateGridTiled(grid, newGrid, n, steps, tile, work, threads[t]);
+			char ** temp = grid;
+			grid = newGrid;
+			newGrid = temp;
+		}
+		clock_gettime(CLOCK_MONOTONIC, &tend);
+	  timer = (tend.tv_sec-tstart.tv_sec) +
+	        (tend.tv_nsec-tstart.tv_nsec)*1.0e-9;
+		printf("tiled time in s, K=%d, tile=%d, %d threads: %f (%.1f Mcell-updates/s)\n",
+				K, tile, threads[t], timer, cells/timer*1e-6);
+		if(memcmp(grid[0], ref[0], (size_t)n*n)){
+			printf("tiled result with %d threads differs from reference\n",
+					threads[t]);
+			passed = 0;
+		}
+	}
+	if(passed)
+		printf("result verified\n");
+	return 0;
+}
+
+void updateGrid(char **grid, char **newGrid, int n){
+	for(int i=0; i<n; i++)
+		for(int j=0; j<n; j++){
+			int up = (i-1+n)%n;
+			int down = (i+1)%n;
+			int left = (j-1+n)%n;
+			int right = (j+1)%n;
+			int sumAlive = grid[up][left] + grid[up][j] + grid[up][right] +
+					grid[i][left] + grid[i][right] +
+					grid[down][left] + grid[down][j] + grid[down][right];
+			if(0 == grid[i][j] && 3 == sumAlive)
+				newGrid[i][j] = 1;
+			else if( 1 == grid[i][j] && (2 == sumAlive || 3 == sumAlive))
+				newGrid[i][j] = 1;
+			else
+				newGrid[i][j] = 0;
+		}
+}
+
+void updateGridTiled(char **grid, char **newGrid, int n, int K, int tile,
+		char *work, int nt){
+	int L = tile + 2*K; //width of local array
+	int nb = (n + tile - 1)/tile; //number of blocks per dimension
+	#pragma omp parallel num_threads(nt)
+	{
+		char *a = work + (size_t)2*L*L*omp_get_thread_num();
+		char *b = a + (size_t)L*L;
+		#pragma omp for schedule(dynamic) collapse(2)
+		for(int bi=0; bi<nb; bi++)
+			for(int bj=0; bj<nb; bj++){
+				int i0 = bi*tile, j0 = bj*tile;
+				int mi = (n-i0 < tile) ? n-i0 : tile; //block may be
+				int mj = (n-j0 < tile) ? n-j0 : tile; //cut off at edge
+				int li = mi + 2*K, lj = mj + 2*K;
+				//copy block and halo, wrapping around edges of grid
+				for(int i=0; i<li; i++){
+					char *row = grid[((i0-K+i)%n + n)%n];
+					int j = ((j0-K)%n + n)%n;
+					for(int jj=0; jj<lj; jj++){
+						a[i*L+jj] = row[j];
+						if(++j == n)
+							j = 0;
+					}
+				}
+				//trapezoid: valid region shrinks by 1 each generation
+				for(int s=1; s<=K; s++){
+					updateLocal(a, b, L, s, li-s, lj-s);
+					char *temp = a;
+					a = b;
+					b = temp;
+				}
+				for(int i=0; i<mi; i++)
+					memcpy(&newGrid[i0+i][j0], &a[(K+i)*L+K], mj);
+			}
+	}
+}
+
+void updateLocal(char *a, char *b, int L, int lo, int hi, int hj){
+	for(int i=lo; i<hi; i++){
+		char *up = a + (i-1)*L, *mid = a + i*L, *down = a + (i+1)*L;
+		char *out = b + i*L;
+		for(int j=lo; j<hj; j++){
+			int sumAlive = up[j-1] + up[j] + up[j+1] + mid[j-1] + mid[j+1] +
+					down[j-1] + down[j] + down[j+1];
+			out[j] = (3 == sumAlive) | (2 == sumAlive && mid[j]);
+		}
+	}
+}
+
+char **initialize(int seed, int n){
+	char *temp = calloc((size_t)n*n, sizeof(char));
+	char **grid = malloc(n*sizeof(char *));
+	if(!temp || !grid)
+		return NULL;
+	if(-1 == seed)
+		srand(time(NULL));
+	else
+		srand(seed);
+	for(size_t i=0; i<(size_t)n*n; i++)
+		if(rand() > RAND_MAX/2)
+			temp[i] = 1;
+	for(int i=0; i<n; i++)
+		grid[i] = temp + (size_t)i*n;
+	return grid;
+}
+
+char **allocate2D(int n){
+		char *temp = malloc((size_t)n*n*sizeof(char));
+		char **a = malloc(n*sizeof(char *));
+		if(!temp || !a)
+			return NULL;
+		for(int i=0; i<n; i++)
+			a[i] = temp + (size_t)i*n;
+		return a;
+}
@@ -0,0 +1,138 @@
+/* Copyright 2017 Eric Aubanel
+ * This file contains code implementing Algorithms 4.5 and 4.10 from
+ * Elements of Parallel Computing, by Eric Aubanel, 2016, CRC Press.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------
+ * Monte Carlo integration with the engine of mcIntegrate.h, which
+ * generalizes the pi estimation of Algorithms 4.5 and 4.10 to any
+ * integrand over the unit cube. Integrands with known integrals:
+ *   pi:    4 inside quarter circle x0^2 + x1^2 <= 1 (dim 2), integral pi
+ *   ball:  2^dim inside unit ball, after mapping cube to [-1,1)^dim,
+ *          integral is volume of ball, pi^(dim/2)/Gamma(dim/2+1)
+ *   gauss: exp(-|x|^2), integral (sqrt(pi)/2 erf(1))^dim
+ * Back end is openmp (OMP_NUM_THREADS threads), forkjoin (WS_NUM_WORKERS
+ * workers) or mpi (compile with mpicc -DUSE_MPI). Integration stops when
+ * the standard error reaches target, or after n samples.
+ * Outputs estimate, standard error, actual error, samples and samples/s.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#ifdef USE_MPI
+#include "mpi.h"
+#endif
+#include "workSteal.h"
+#include "mcIntegrate.h"
+
+double piIntegrand(const double *x, int dim, void *params);
+double ballIntegrand(const double *x, int dim, void *params);
+double gaussIntegrand(const double *x, int dim, void *params);
+// ends MPI (if used) and returns status
+int finish(int status);
+
+int main(int argc, char **argv){
+	int rank = 0;
+#ifdef USE_MPI
+	MPI_Init(&argc, &argv);
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+#endif
+	if(argc < 5){
+		if(!rank)
+			fprintf(stderr,"usage: %s pi|ball|gauss dim openmp|forkjoin|mpi n "
+					"[targetError [seed]]\n", argv[0]);
+		return finish(1);
+	}
+	McProblem p;
+	p.dim = strtol(argv[2], NULL, 10);
+	long n = strtol(argv[4], NULL, 10);
+	double target = argc > 5 ? strtod(argv[5], NULL) : 0;
+	p.seed = argc > 6 ? strtoull(argv[6], NULL, 10) : 1;
+	p.params = NULL;
+	double exact;
+	if(!strcmp(argv[1], "pi")){
+		p.f = piIntegrand;
+		p.dim = 2;
+		exact = M_PI;
+	} else if(!strcmp(argv[1], "ball")){
+		p.f = ballIntegrand;
+		exact = pow(M_PI, p.dim/2.0)/tgamma(p.dim/2.0+1);
+	} else if(!strcmp(argv[1], "gauss")){
+		p.f = gaussIntegrand;
+		exact = pow(sqrt(M_PI)/2*erf(1), p.dim);
+	} else{
+		if(!rank)
+			fprintf(stderr,"unknown integrand %s\n", argv[1]);
+		return finish(1);
+	}
+	enum McBackend b = MC_NUM_BACKENDS;
+	for(int i=0; i<MC_NUM_BACKENDS; i++)
+		if(!strcmp(argv[3], mcBackendName(i)))
+			b = i;
+	if(b == MC_FORKJOIN)
+		wsInit(0);
+	if(p.dim < 1 || n < 1 || b == MC_NUM_BACKENDS || !mcBackendAvailable(b)){
+		if(!rank)
+			fprintf(stderr,"dim and n must be positive, and back end %s "
+					"available\n", argv[3]);
+		return finish(1);
+	}
+
+	McResult r = mcIntegrate(&p, b, n, target);
+	if(!rank){
+		printf("%s, dim %d, %s back end, seed %llu\n", argv[1], p.dim,
+				mcBackendName(b), (unsigned long long)p.seed);
+		printf("estimate: %.10f, exact: %.10f\n", r.estimate, exact);
+		printf("standard error: %.3e, error: %.3e\n", r.stdError,
+				fabs(r.estimate - exact));
+		printf("%ld samples in %d rounds, %s\n", r.samples, r.rounds,
+				r.converged ? "target error reached" : "target error not reached");
+		printf("time in s: %f, samples/s: %g\n", r.time, r.samples/r.time);
+	}
+	if(b == MC_FORKJOIN)
+		wsFinalize();
+	return finish(0);
+}
+
+int finish(int status){
+#ifdef USE_MPI
+	MPI_Finalize();
+#endif
+	return status;
+}
+
+double piIntegrand(const double *x, int dim, void *params){
+	(void)dim; (void)params;
+	return x[0]*x[0] + x[1]*x[1] <= 1.0 ? 4 : 0;
+}
+
+double ballIntegrand(const double *x, int dim, void *params){
+	(void)params;
+	double r2 = 0;
+	for(int j=0; j<dim; j++){
+		double y = 2*x[j]-1;
+		r2 += y*y;
+	}
+	return r2 <= 1.0 ? ldexp(1.0, dim) : 0;
+}
+
+double gaussIntegrand(const double *x, int dim, void *params){
+	(void)params;
+	double r2 = 0;
+	for(int j=0; j<dim; j++)
+		r2 += x[j]*x[j];
+	return exp(-r2);
+}
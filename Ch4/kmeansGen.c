@@ -0,0 +1,69 @@
+/* Copyright 2017 Eric Aubanel
+ * This file contains code supporting Algorithm  3.1 from
+ * Elements of Parallel Computing, by Eric Aubanel, 2016, CRC Press.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------
+ * Generates n 2D points for k-means, in the format of Ch3/kmeans.c,
+ * written to stdout. Points are normally distributed, with standard
+ * deviation SIGMA, around k centers chosen uniformly in
+ * [0,RANGE) x [0,RANGE).
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define RANGE 100.0
+#define SIGMA 2.0
+
+// uniform random number in (0,1)
+double uniform(void);
+
+int main(int argc, char **argv){
+	if(argc <3){
+		fprintf(stderr,"usage: %s n k [seed]\n", argv[0]);
+		return 1;
+	}
+	long n = strtol(argv[1], NULL, 10);
+	int k = strtol(argv[2], NULL, 10);
+	if(n < 1 || k < 1){
+		fprintf(stderr,"n and k must be positive\n");
+		return 1;
+	}
+	srand(argc > 3 ? strtol(argv[3], NULL, 10) : 1);
+	double *cx = malloc(k*sizeof(double));
+	double *cy = malloc(k*sizeof(double));
+	if(!cx || !cy){
+		fprintf(stderr,"couldn't allocate memory for %d centers\n", k);
+		return 1;
+	}
+	for(int i=0; i<k; i++){
+		cx[i] = RANGE*uniform();
+		cy[i] = RANGE*uniform();
+	}
+	printf("%ld\n", n);
+	for(long j=0; j<n; j++){
+		int i = (int)(k*uniform());
+		//Box-Muller transform
+		double r = SIGMA*sqrt(-2.0*log(uniform()));
+		double theta = 2.0*M_PI*uniform();
+		printf("%.6f %.6f\n", cx[i] + r*cos(theta), cy[i] + r*sin(theta));
+	}
+	return 0;
+}
+
+double uniform(void){
+	return (rand() + 1.0)/(RAND_MAX + 2.0);
+}
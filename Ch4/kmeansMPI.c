@@ -0,0 +1,251 @@
+/* Copyright 2017 Eric Aubanel
+ * This file contains code extending Algorithm  3.1 from
+ * Elements of Parallel Computing, by Eric Aubanel, 2016, CRC Press.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------
+ * MPI implementation of 2-dimensional k-means algorithm
+ * Reads a file of points in the format of Ch3/kmeans.c. Each process
+ * reads the lines that start in its part of the file (the file is
+ * divided into p parts with the same number of bytes).
+ * If k is given in the command line the first k points are the
+ * initial cluster centers, otherwise process 0 prompts for k and the
+ * centers as in kmeans.c.
+ * In each iteration each process assigns its points to the closest
+ * center and sums the coordinates and number of points in each
+ * cluster, then a single allreduce combines the sums, along with the
+ * number of points that changed cluster, so every process computes the
+ * new centers and knows if the algorithm has converged.
+ * Process 0 outputs the time to read the file and for the iterations,
+ * and the final cluster centers.
+ * kmeansGen.c generates large input files, and kmeansScaling.sh
+ * measures speedup.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "mpi.h"
+
+typedef struct{
+	double *x, *y;
+} Vector;
+
+// allocate struct of 2 arrays of doubles of length n
+void allocVector(Vector *v, int n);
+// Return the index of the closest cluster center to (x,y)
+int findClosest(double x, double y, Vector cluster, int k);
+// read points from lines of file that start in part id of p,
+// returns number of points read (or -1 if error), stored in vector
+int readSlice(const char *name, int id, int p, Vector *vector);
+
+int main(int argc, char **argv){
+	int k; // number of clusters
+	Vector vector; // my vectors
+	Vector cluster; // cluster centers
+	int *closest; //assignment of my vectors to cluster centers
+	int id; //my id
+	int p; //number of processes
+	double time;
+
+	MPI_Init(&argc, &argv);
+	MPI_Comm_rank(MPI_COMM_WORLD, &id);
+	MPI_Comm_size(MPI_COMM_WORLD, &p);
+
+	if(argc <2){
+		if(!id) fprintf(stderr,"usage: %s filename [k]\n", argv[0]);
+		MPI_Finalize();
+		return 1;
+	}
+
+	MPI_Barrier(MPI_COMM_WORLD);
+	time = -MPI_Wtime();
+	int m = readSlice(argv[1], id, p, &vector); //number of my points
+	int ok = m >= 0, allOk;
+	MPI_Allreduce(&ok, &allOk, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+	if(!allOk){
+		if(!id) fprintf(stderr,"something wrong with data in file %s\n", argv[1]);
+		MPI_Finalize();
+		return 1;
+	}
+	long myN = m, n;
+	MPI_Allreduce(&myN, &n, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+	time += MPI_Wtime();
+	double readTime;
+	MPI_Reduce(&time, &readTime, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+	// Read clusters and initialize cluster arrays
+	if(!id){
+		if(argc > 2){
+			k = strtol(argv[2], NULL, 10);
+			FILE *f = fopen(argv[1], "r");
+			if(k < 1 || k > n || !f || fscanf(f, "%*d") != 0)
+				k = 0;
+			allocVector(&cluster, k > 0 ? k : 1);
+			for(int i=0; i<k; i++)
+				if(fscanf(f, "%lf %lf", &cluster.x[i], &cluster.y[i]) != 2)
+					k = 0;
+			if(f)
+				fclose(f);
+		} else{
+			printf("enter number of clusters: ");
+			if(scanf("%d", &k) != 1 || k < 1)
+				k = 0;
+			allocVector(&cluster, k > 0 ? k : 1);
+			if(k > 0)
+				printf("enter coordinates for guess of %d clusters\n", k);
+			for(int i=0; i<k; i++)
+				if(scanf("%lf %lf", &cluster.x[i], &cluster.y[i]) != 2)
+					k = 0;
+		}
+	}
+	MPI_Bcast(&k, 1, MPI_INT, 0, MPI_COMM_WORLD);
+	if(k == 0){
+		if(!id) fprintf(stderr,"something wrong with clusters\n");
+		MPI_Finalize();
+		return 1;
+	}
+	if(id)
+		allocVector(&cluster, k);
+	MPI_Bcast(cluster.x, k, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+	MPI_Bcast(cluster.y, k, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+	//sums of x and y, cluster sizes and number of changed assignments
+	double *sums = malloc((3*k+1)*sizeof(double));
+	if((closest = malloc((m > 0 ? m : 1)*sizeof(int))) == NULL || !sums){
+		fprintf(stderr,"couldn't allocate memory\n");
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+	double *sumx = sums, *sumy = sums + k, *size = sums + 2*k;
+	for(int j=0; j<m; j++)
+		closest[j] = 0;
+
+	// k-means
+	MPI_Barrier(MPI_COMM_WORLD);
+	time = -MPI_Wtime();
+	int iter = 0;
+	double changed = 1;
+	while(changed > 0){
+		for(int i=0; i<3*k+1; i++)
+			sums[i] = 0.0;
+		for(int j=0; j<m; j++){
+			int i = findClosest(vector.x[j], vector.y[j], cluster, k);
+			if(i != closest[j])
+				sums[3*k] += 1;
+			closest[j] = i;
+			sumx[i] += vector.x[j];
+			sumy[i] += vector.y[j];
+			size[i] += 1;
+		}
+		MPI_Allreduce(MPI_IN_PLACE, sums, 3*k+1, MPI_DOUBLE, MPI_SUM,
+				MPI_COMM_WORLD);
+		for(int i=0; i<k; i++){
+			cluster.x[i] = sumx[i]/size[i];
+			cluster.y[i] = sumy[i]/size[i];
+		}
+		changed = sums[3*k];
+		iter++;
+	}
+	time += MPI_Wtime();
+	double ptime;
+	MPI_Reduce(&time, &ptime, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+	if(!id){
+		printf("%ld points, %d clusters, %d processes\n", n, k, p);
+		printf("read time in seconds: %f\n", readTime);
+		printf("%d iterations, time in seconds: %f\n", iter, ptime);
+		printf("time per iteration in seconds: %e\n", ptime/iter);
+		for(int i=0; i<k; i++)
+			printf("%f %f\n", cluster.x[i], cluster.y[i]);
+	}
+	MPI_Finalize();
+	return 0;
+}
+
+int readSlice(const char *name, int id, int p, Vector *vector){
+	FILE *f = fopen(name, "r");
+	if(f == NULL)
+		return -1;
+	//First line of file indicates number of points
+	char *line = NULL;
+	size_t len = 0;
+	if(getline(&line, &len, f) < 0){
+		fclose(f);
+		return -1;
+	}
+	long start = ftell(f);
+	fseek(f, 0, SEEK_END);
+	long size = ftell(f) - start;
+	long lo = start + size*id/p;
+	long hi = start + size*(id+1)/p;
+	//skip line that starts in previous part
+	if(lo > start){
+		fseek(f, lo-1, SEEK_SET);
+		if(fgetc(f) != '\n')
+			getline(&line, &len, f);
+	} else
+		fseek(f, lo, SEEK_SET);
+
+	int cap = 1024, m = 0;
+	allocVector(vector, cap);
+	while(ftell(f) < hi && getline(&line, &len, f) > 0){
+		double x, y;
+		char c;
+		int r = sscanf(line, "%lf %lf", &x, &y);
+		if(r != 2){
+			//allow blank lines
+			if(sscanf(line, " %c", &c) == 1){
+				fclose(f);
+				return -1;
+			}
+			continue;
+		}
+		if(m == cap){
+			cap *= 2;
+			vector->x = realloc(vector->x, cap*sizeof(double));
+			vector->y = realloc(vector->y, cap*sizeof(double));
+			if(!vector->x || !vector->y){
+				fprintf(stderr,"couldn't allocate memory for %d doubles\n", cap);
+				MPI_Abort(MPI_COMM_WORLD, 1);
+			}
+		}
+		vector->x[m] = x;
+		vector->y[m] = y;
+		m++;
+	}
+	free(line);
+	fclose(f);
+	return m;
+}
+
+void allocVector(Vector *v, int n){
+	v->x = malloc(n*sizeof(double));
+	v->y = malloc(n*sizeof(double));
+	if(v->x == NULL || v->y == NULL){
+		fprintf(stderr,"couldn't allocate memory for %d doubles\n", n);
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+}
+
+int findClosest(double x, double y, Vector cluster, int k){
+	double min = (x-cluster.x[0])*(x-cluster.x[0]) + (y-cluster.y[0])*(y-cluster.y[0]);
+	int mini = 0;
+	for(int i=1; i<k; i++){
+		double d = (x-cluster.x[i])*(x-cluster.x[i]) + (y-cluster.y[i])*(y-cluster.y[i]);
+		if(d < min){
+			min = d;
+			mini = i;
+		}
+	}
+	return mini;
+}
@@ -0,0 +1,341 @@
+/* Copyright 2017 Eric Aubanel
+ * This file contains code extending Algorithm  3.1 from
+ * Elements of Parallel Computing, by Eric Aubanel, 2016, CRC Press.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------
+ * OpenMP implementation of 2-dimensional k-means algorithm
+ * Reads a file of points in the format of Ch3/kmeans.c. If k is given
+ * in the command line the first k points are the initial cluster
+ * centers, otherwise prompts for k and the centers as in kmeans.c.
+ * The assignment step is parallelized over blocks of BLOCK points.
+ * Within a block, squared distances to each cluster center are
+ * computed in a loop over points, which vectorizes over the x and y
+ * arrays, keeping the running minimum and its index in small arrays
+ * (updated with selects rather than a branch, so the loop vectorizes).
+ * Each thread accumulates the sums and sizes of its clusters in
+ * private arrays, which are combined by an array reduction.
+ * Runs the serial loop of kmeans.c, then the parallel version for
+ * 1, 2, 4, ... up to the maximum number of threads, and outputs
+ * time per iteration, a speedup table, and the number of points
+ * assigned differently than by the serial loop (summing in a
+ * different order can move centers by a rounding error).
+ * Compile with: gcc -O2 -fopenmp kmeansOMP.c -o kmeansOMP -lm
+ * (-O2 or higher is needed for vectorization, and -march=native gives
+ * wider vectors where available).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <omp.h>
+
+#define BLOCK 256 //points per block in assignment step
+#define MAX_ITER 1000 //maximum iterations timed
+
+typedef struct{
+	double *x, *y;
+} Vector;
+
+// allocate struct of 2 arrays of doubles of length n
+void allocVector(Vector *v, int n);
+// Return the index of the closest cluster center to (x,y)
+int findClosest(double x, double y, Vector cluster, int k);
+// k-means loop of kmeans.c, starting from centers init, assignment
+// stored in closest, time of each iteration in iterTime;
+// returns number of iterations
+int kmeansSerial(Vector vector, int n, Vector init, int k, int *closest,
+		double *iterTime);
+// parallel k-means with nt threads, same arguments as kmeansSerial
+int kmeansOMP(Vector vector, int n, Vector init, int k, int *closest,
+		double *iterTime, int nt);
+
+int main(int argc, char **argv){
+	int n; // number of vectors
+	int k; // numbef of clusters
+	Vector vector; // vectors
+	Vector cluster; // initial cluster centers
+
+	if(argc <2){
+		fprintf(stderr,"usage: %s filename [k]\n", argv[0]);
+		return 1;
+	}
+	FILE *f = fopen(argv[1], "r");
+	if(f == NULL){
+		fprintf(stderr,"can't open file %s\n", argv[1]);
+		return 1;
+	}
+	//First line of file should indicate number of points
+	if(fscanf(f, "%d", &n) != 1 || n < 1){
+		fprintf(stderr,"something wrong with data in file\n");
+		return 1;
+	}
+	allocVector(&vector, n);
+	for(int i=0; i<n; i++){
+		if(fscanf(f, "%lf %lf", &vector.x[i], &vector.y[i]) != 2){
+			fprintf(stderr,"something wrong with data in file\n");
+			return 1;
+		}
+	}
+	fclose(f);
+
+	if(argc > 2){
+		k = strtol(argv[2], NULL, 10);
+		if(k < 1 || k > n){
+			fprintf(stderr,"k must be between 1 and %d\n", n);
+			return 1;
+		}
+		allocVector(&cluster, k);
+		memcpy(cluster.x, vector.x, k*sizeof(double));
+		memcpy(cluster.y, vector.y, k*sizeof(double));
+	} else{
+		printf("enter number of clusters: ");
+		if(scanf("%d", &k) != 1 || k < 1){
+			fprintf(stderr,"something wrong with number of clusters\n");
+			return 1;
+		}
+		allocVector(&cluster, k);
+		printf("enter coordinates for guess of %d clusters\n", k);
+		for(int i=0; i<k; i++){
+			if(scanf("%lf %lf", &cluster.x[i], &cluster.y[i]) != 2){
+				fprintf(stderr,"something wrong with coordinate\n");
+				return 1;
+			}
+		}
+	}
+
+	int maxThreads = omp_get_max_threads();
+	int nruns = 1; //serial loop, then thread counts
+	int threads[64];
+	for(int t=1; t<maxThreads; t*=2)
+		threads[nruns++] = t;
+	threads[nruns++] = maxThreads;
+	threads[0] = 0;
+	int *iters = malloc(nruns*sizeof(int));
+	double *iterTime = malloc((size_t)nruns*MAX_ITER*sizeof(double));
+	int *closestSerial = malloc(n*sizeof(int));
+	int *closest = malloc(n*sizeof(int));
+	if(!iters || !iterTime || !closestSerial || !closest){
+		fprintf(stderr,"couldn't allocate memory\n");
+		return 1;
+	}
+
+	iters[0] = kmeansSerial(vector, n, cluster, k, closestSerial, iterTime);
+	printf("n = %d, k = %d\n", n, k);
+	printf("%8s %6s %12s %12s %8s %10s\n", "threads", "iters", "time (s)",
+			"s/iter", "speedup", "different");
+	double serialPerIter = 0.0;
+	for(int r=0; r<nruns; r++){
+		if(r > 0)
+			iters[r] = kmeansOMP(vector, n, cluster, k, closest,
+					iterTime + r*MAX_ITER, threads[r]);
+		double time = 0.0;
+		int timed = iters[r] < MAX_ITER ? iters[r] : MAX_ITER;
+		for(int i=0; i<timed; i++)
+			time += iterTime[r*MAX_ITER + i];
+		double perIter = time/timed;
+		int diff = 0;
+		if(r == 0){
+			serialPerIter = perIter;
+			printf("%8s", "serial");
+		} else{
+			for(int j=0; j<n; j++)
+				diff += closest[j] != closestSerial[j];
+			printf("%8d", threads[r]);
+		}
+		printf(" %6d %12f %12e %8.2f %10d\n", iters[r], time, perIter,
+				serialPerIter/perIter, diff);
+	}
+
+	printf("time per iteration (s)\n%6s", "iter");
+	for(int r=0; r<nruns; r++)
+		if(r == 0)
+			printf(" %12s", "serial");
+		else
+			printf(" %12d", threads[r]);
+	putchar('\n');
+	int maxIters = 0;
+	for(int r=0; r<nruns; r++)
+		if(iters[r] > maxIters)
+			maxIters = iters[r];
+	if(maxIters > MAX_ITER)
+		maxIters = MAX_ITER;
+	for(int i=0; i<maxIters; i++){
+		printf("%6d", i+1);
+		for(int r=0; r<nruns; r++)
+			if(i < iters[r])
+				printf(" %12e", iterTime[r*MAX_ITER + i]);
+			else
+				printf(" %12s", "-");
+		putchar('\n');
+	}
+	return 0;
+}
+
+void allocVector(Vector *v, int n){
+	v->x = malloc(n*sizeof(double));
+	v->y = malloc(n*sizeof(double));
+	if(v->x == NULL || v->y == NULL){
+		fprintf(stderr,"couldn't allocate memory for %d doubles\n", n);
+		exit(1);
+	}
+}
+
+int kmeansSerial(Vector vector, int n, Vector init, int k, int *closest,
+		double *iterTime){
+	Vector cluster, clusterNew;
+	int *clusterSize;
+	allocVector(&cluster, k);
+	allocVector(&clusterNew, k);
+	if((clusterSize = malloc(k*sizeof(int))) == NULL){
+		fprintf(stderr,"couldn't allocate array of %d ints\n", k);
+		exit(1);
+	}
+	for(int i=0; i<k; i++){
+		cluster.x[i] = init.x[i];
+		cluster.y[i] = init.y[i];
+		clusterNew.x[i] = clusterNew.y[i] = 0.0;
+		clusterSize[i] = 0;
+	}
+	for(int j=0; j<n; j++)
+		closest[j] = 0;
+
+	int iter = 0;
+	bool converged = false;
+	while(!converged){
+		double time = omp_get_wtime();
+		converged = true;
+		for(int j=0; j<n; j++){
+			int i = findClosest(vector.x[j], vector.y[j], cluster, k);
+			if(i != closest[j])
+				converged = false;
+			closest[j] = i;
+			clusterNew.x[i] += vector.x[j];
+			clusterNew.y[i] += vector.y[j];
+			clusterSize[i]++;
+		}
+		for(int i=0; i<k; i++){
+			cluster.x[i] = clusterNew.x[i]/clusterSize[i];
+			cluster.y[i] = clusterNew.y[i]/clusterSize[i];
+			clusterNew.x[i] = clusterNew.y[i] = 0.0;
+			clusterSize[i] = 0.0;
+		}
+		if(iter < MAX_ITER)
+			iterTime[iter] = omp_get_wtime() - time;
+		iter++;
+	}
+	free(cluster.x); free(cluster.y);
+	free(clusterNew.x); free(clusterNew.y);
+	free(clusterSize);
+	return iter;
+}
+
+int kmeansOMP(Vector vector, int n, Vector init, int k, int *closest,
+		double *iterTime, int nt){
+	Vector cluster, clusterNew;
+	int *clusterSize;
+	allocVector(&cluster, k);
+	allocVector(&clusterNew, k);
+	if((clusterSize = malloc(k*sizeof(int))) == NULL){
+		fprintf(stderr,"couldn't allocate array of %d ints\n", k);
+		exit(1);
+	}
+	for(int i=0; i<k; i++){
+		cluster.x[i] = init.x[i];
+		cluster.y[i] = init.y[i];
+	}
+	#pragma omp parallel for num_threads(nt)
+	for(int j=0; j<n; j++)
+		closest[j] = 0;
+
+	double *cx = cluster.x, *cy = cluster.y;
+	double *sumx = clusterNew.x, *sumy = clusterNew.y;
+	int *size = clusterSize;
+	int iter = 0;
+	int changed = 1;
+	while(changed){
+		double time = omp_get_wtime();
+		changed = 0;
+		for(int i=0; i<k; i++){
+			sumx[i] = sumy[i] = 0.0;
+			size[i] = 0;
+		}
+		#pragma omp parallel for num_threads(nt) schedule(static) \
+				reduction(+:changed, sumx[:k], sumy[:k], size[:k])
+		for(int b=0; b<n; b+=BLOCK){
+			double dmin[BLOCK]; //squared distance to closest center so far
+			//index of that center, as double so selects below have the
+			//same vector width as distances
+			double imin[BLOCK];
+			int len = n-b < BLOCK ? n-b : BLOCK;
+			const double *x = vector.x + b, *y = vector.y + b;
+			#pragma omp simd
+			for(int j=0; j<len; j++){
+				double dx = x[j] - cx[0], dy = y[j] - cy[0];
+				dmin[j] = dx*dx + dy*dy;
+				imin[j] = 0;
+			}
+			for(int i=1; i<k; i++){
+				double cxi = cx[i], cyi = cy[i], di = i;
+				#pragma omp simd
+				for(int j=0; j<len; j++){
+					double dx = x[j] - cxi, dy = y[j] - cyi;
+					double d = dx*dx + dy*dy;
+					//selects rather than a branch, so loop vectorizes (the
+					//index select tests the new minimum, as gcc turns
+					//d < dm ? di : imin[j] back into a conditional store)
+					double dm = dmin[j];
+					double m = d < dm ? d : dm;
+					imin[j] = m == dm ? imin[j] : di;
+					dmin[j] = m;
+				}
+			}
+			for(int j=0; j<len; j++){
+				int i = (int)imin[j];
+				changed += i != closest[b+j];
+				closest[b+j] = i;
+				sumx[i] += x[j];
+				sumy[i] += y[j];
+				size[i]++;
+			}
+		}
+		for(int i=0; i<k; i++){
+			cx[i] = sumx[i]/size[i];
+			cy[i] = sumy[i]/size[i];
+		}
+		if(iter < MAX_ITER)
+			iterTime[iter] = omp_get_wtime() - time;
+		iter++;
+	}
+	free(cluster.x); free(cluster.y);
+	free(clusterNew.x); free(clusterNew.y);
+	free(clusterSize);
+	return iter;
+}
+
+int findClosest(double x, double y, Vector cluster, int k){
+	double min = sqrt((x-cluster.x[0])*(x-cluster.x[0]) + (y-cluster.y[0])*(y-cluster.y[0]));
+	int mini = 0;
+	for(int i=1; i<k; i++){
+		double d = sqrt((x-cluster.x[i])*(x-cluster.x[i]) + (y-cluster.y[i])*(y-cluster.y[i]));
+		if(d < min){
+			min = d;
+			mini = i;
+		}
+	}
+	return mini;
+}
@@ -0,0 +1,53 @@
+#!/bin/sh
+# Strong and weak scaling of kmeansMPI.c, with input files in the
+# format of kmeans.c (e.g. Ch3/kmeansEg.txt) made by kmeansGen.c.
+# usage: kmeansScaling.sh [n [k [maxp]]]
+# Strong scaling uses n points for all p; weak scaling uses n*p points.
+# Since the number of iterations depends on the data, speedup is
+# computed from time per iteration.
+# Set MPIRUN to change how programs are launched, and TMPDIR to change
+# where input files are written.
+
+n=${1:-1000000}
+k=${2:-16}
+maxp=${3:-4}
+MPIRUN=${MPIRUN:-mpirun}
+dir=$(dirname "$0")
+tmp=${TMPDIR:-/tmp}
+
+cc -O2 -std=gnu99 -o kmeansGen "$dir/kmeansGen.c" -lm || exit 1
+mpicc -O2 -std=gnu99 -o kmeansMPI "$dir/kmeansMPI.c" || exit 1
+
+# prints read time, iterations, time per iteration and speedup
+# with p processes and file of size points
+run(){
+	p=$1
+	size=$2
+	file="$tmp/kmeans$size.txt"
+	[ -f "$file" ] || ./kmeansGen "$size" "$k" > "$file"
+	out=$($MPIRUN -np "$p" ./kmeansMPI "$file" "$k")
+	read=$(echo "$out" | sed -n 's/read time in seconds: //p')
+	iters=$(echo "$out" | sed -n 's/ iterations.*//p')
+	periter=$(echo "$out" | sed -n 's/time per iteration in seconds: //p')
+	[ "$p" -eq 1 ] && base=$periter
+	speedup=$(awk "BEGIN{printf \"%.2f\", $base/$periter}")
+	printf "%4d %10d %10s %6s %14s %8s\n" "$p" "$size" "$read" "$iters" \
+			"$periter" "$speedup"
+}
+
+echo "strong scaling, k=$k"
+printf "%4s %10s %10s %6s %14s %8s\n" p n "read (s)" iters "s/iter" speedup
+p=1
+while [ $p -le "$maxp" ]; do
+	run $p "$n"
+	p=$((p*2))
+done
+
+echo "weak scaling, k=$k (speedup is scaled by p)"
+printf "%4s %10s %10s %6s %14s %8s\n" p n "read (s)" iters "s/iter" speedup
+p=1
+while [ $p -le "$maxp" ]; do
+	run $p $((n*p)) | awk -v p=$p '{$6 = sprintf("%.2f", $6*p);
+			printf "%4d %10d %10s %6s %14s %8s\n", $1, $2, $3, $4, $5, $6}'
+	p=$((p*2))
+done
@@ -19,12 +19,15 @@
  * Implementation of column-wise SIMD nxn matrix-vector multiplication
  * where n is a power of two
  * using Cilk Plus
- * If SIMD not defined, uses array notation
- * If SIMD defined (compile with -DSIMD), uses SIMD pragma
+ * If SIMD not defined and compiler has Cilk Plus, uses array notation
+ * If SIMD defined (compile with -DSIMD), or compiler lacks Cilk Plus (as
+ * current gcc), uses OpenMP SIMD pragma (compile with -fopenmp-simd)
  */
 #include <stdio.h>
 #include <stdlib.h>
+#ifdef __cilk
 #include <cilk/cilk.h>
+#endif
 #include <time.h>
 #include <float.h>
 #include <math.h>
@@ -60,21 +63,21 @@ int main(int argc, char **argv){
 	struct timespec tstart,tend;
 	float time;
 	clock_gettime(CLOCK_MONOTONIC, &tstart);
-	#ifdef SIMD
-	#pragma SIMD
+	#if defined(SIMD) || !defined(__cilk)
+	#pragma omp simd
 	for(int i=0; i<n; i++)
 		b[i] = 0.0;
 	#else
 	b[0:n] = 0.0;
 	#endif
 	for(int i=0;i<n;i++){
-	#ifdef SIMD
-		#pragma SIMD
+	#if defined(SIMD) || !defined(__cilk)
+		#pragma omp simd
 		for(int j=0; j<n; j++)
 			temp[j] = A[i][j]*x[j];
 		for (int k=exp-1; k>=0; k--){
 			int k2 = 1<<k;
-			#pragma SIMD
+			#pragma omp simd
 			for(int j=0; j<k2; j++)
 				temp[j] += temp[j+k2];
 		}
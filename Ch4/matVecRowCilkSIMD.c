@@ -18,14 +18,17 @@
  * -------------------------------------------------------------------
  * Implementation of row-wise SIMD nxn matrix-vector multiplication
  * using Cilk Plus
- * If SIMD not defined, uses array notation
- * If SIMD defined (compile with -DSIMD), uses SIMD pragma
+ * If SIMD not defined and compiler has Cilk Plus, uses array notation
+ * If SIMD defined (compile with -DSIMD), or compiler lacks Cilk Plus (as
+ * current gcc), uses OpenMP SIMD pragma (compile with -fopenmp-simd)
  * Note: inner mat-vec loop not vectorized by gcc 6.1.0 because of 
  * scattered data accesses
  */
 #include <stdio.h>
 #include <stdlib.h>
+#ifdef __cilk
 #include <cilk/cilk.h>
+#endif
 #include <time.h>
 #include <float.h>
 #include <math.h>
@@ -58,16 +61,16 @@ int main(int argc, char **argv){
 	struct timespec tstart,tend;
 	float time;
 	clock_gettime(CLOCK_MONOTONIC, &tstart);
-	#ifdef SIMD
-	#pragma SIMD
+	#if defined(SIMD) || !defined(__cilk)
+	#pragma omp simd
 	for(int i=0; i<n; i++)
 		b[i] = 0.0;
 	#else
 	b[0:n] = 0.0;
 	#endif
 	for(int j=0;j<n;j++)
-	#ifdef SIMD
-		#pragma SIMD
+	#if defined(SIMD) || !defined(__cilk)
+		#pragma omp simd
 		for(int i=0; i<n; i++)
 			b[i] += A[i][j]*x[j];
 	#else
@@ -0,0 +1,184 @@
+// Implementation of parallel Monte Carlo integration (see mcIntegrate.h).
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#ifdef USE_MPI
+#include "mpi.h"
+#endif
+#include "philox.h"
+#include "workSteal.h"
+#include "mcIntegrate.h"
+
+#define MC_CHUNK 256 //points generated at a time in a batch
+
+// mean and sum of squared deviations of integrand values of a batch
+typedef struct{
+	double mean, m2;
+} BatchStats;
+// batches b0 .. b1-1 of p into s[0 .. b1-b0)
+typedef void (*BatchRunner)(const McProblem *p, long b0, long b1,
+		BatchStats *s);
+// arguments of fork-join recursion
+typedef struct{
+	const McProblem *p;
+	long b0, b1;
+	BatchStats *s;
+} BatchArgs;
+
+// integrand values of batch b, with Welford's update
+static void runBatch(const McProblem *p, long b, BatchStats *s);
+static void runOMP(const McProblem *p, long b0, long b1, BatchStats *s);
+static void runForkJoin(const McProblem *p, long b0, long b1, BatchStats *s);
+static void recBatches(void *arg);
+static void runMPI(const McProblem *p, long b0, long b1, BatchStats *s);
+
+static void runBatch(const McProblem *p, long b, BatchStats *s){
+	int dim = p->dim;
+	uint32_t *w = malloc(MC_CHUNK*dim*sizeof(uint32_t));
+	double *x = malloc(dim*sizeof(double));
+	if(!w || !x){
+		fprintf(stderr,"couldn't allocate memory for batch\n");
+		exit(1);
+	}
+	double mean = 0, m2 = 0;
+	for(long i=0; i<MC_BATCH; i+=MC_CHUNK){
+		philoxFill(p->seed, b, (uint64_t)i*dim, w, (long)MC_CHUNK*dim);
+		for(int k=0; k<MC_CHUNK; k++){
+			for(int j=0; j<dim; j++)
+				x[j] = (w[k*dim+j] + 0.5)*0x1p-32;
+			double fx = p->f(x, dim, p->params);
+			double delta = fx - mean;
+			mean += delta/(i+k+1);
+			m2 += delta*(fx - mean);
+		}
+	}
+	s->mean = mean;
+	s->m2 = m2;
+	free(w);
+	free(x);
+}
+
+static void runOMP(const McProblem *p, long b0, long b1, BatchStats *s){
+	#pragma omp parallel for schedule(dynamic)
+	for(long b=b0; b<b1; b++)
+		runBatch(p, b, &s[b-b0]);
+}
+
+static void runForkJoin(const McProblem *p, long b0, long b1, BatchStats *s){
+	BatchArgs args = {p, b0, b1, s};
+	wsRun(recBatches, &args);
+}
+
+static void recBatches(void *arg){
+	BatchArgs *a = arg;
+	if(a->b1 - a->b0 == 1){
+		runBatch(a->p, a->b0, a->s);
+		return;
+	}
+	long mid = (a->b0 + a->b1)/2;
+	BatchArgs left = {a->p, a->b0, mid, a->s};
+	BatchArgs right = {a->p, mid, a->b1, a->s + (mid - a->b0)};
+	WsGroup g = WS_GROUP_INIT;
+	WsTask t;
+	wsSpawn(&g, &t, recBatches, &left);
+	recBatches(&right);
+	wsSync(&g);
+}
+
+static void runMPI(const McProblem *p, long b0, long b1, BatchStats *s){
+#ifdef USE_MPI
+	int rank, size;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	MPI_Comm_size(MPI_COMM_WORLD, &size);
+	memset(s, 0, (b1-b0)*sizeof(BatchStats));
+	for(long b=b0+rank; b<b1; b+=size)
+		runBatch(p, b, &s[b-b0]);
+	//each batch computed by one process, so sum with zeros is exact
+	MPI_Allreduce(MPI_IN_PLACE, s, 2*(b1-b0), MPI_DOUBLE, MPI_SUM,
+			MPI_COMM_WORLD);
+#else
+	//not available (see mcBackendAvailable)
+	(void)p; (void)b0; (void)b1; (void)s;
+#endif
+}
+
+const char *mcBackendName(enum McBackend b){
+	static const char *names[MC_NUM_BACKENDS] = {"openmp", "forkjoin", "mpi"};
+	return names[b];
+}
+
+int mcBackendAvailable(enum McBackend b){
+	switch(b){
+		case MC_OPENMP:
+#ifdef _OPENMP
+			return 1;
+#else
+			return 0;
+#endif
+		case MC_FORKJOIN:
+			return wsNumWorkers() > 0;
+		case MC_MPI:
+#ifdef USE_MPI
+			return 1;
+#else
+			return 0;
+#endif
+		default:
+			return 0;
+	}
+}
+
+McResult mcIntegrate(const McProblem *p, enum McBackend backend,
+		long maxSamples, double targetError){
+	BatchRunner runners[MC_NUM_BACKENDS] = {runOMP, runForkJoin, runMPI};
+	BatchRunner run = runners[backend];
+	long maxBatches = (maxSamples + MC_BATCH-1)/MC_BATCH;
+	if(maxBatches < 1)
+		maxBatches = 1;
+	long round = maxBatches < MC_FIRST_ROUND ? maxBatches : MC_FIRST_ROUND;
+	BatchStats *s = malloc(maxBatches*sizeof(BatchStats));
+	if(!s){
+		fprintf(stderr,"couldn't allocate memory for %ld batches\n", maxBatches);
+		exit(1);
+	}
+	McResult r = {0, INFINITY, 0, 0, 0, 0};
+	double mean = 0, m2 = 0;
+	long done = 0; //batches
+	struct timespec tstart,tend;
+	clock_gettime(CLOCK_MONOTONIC, &tstart);
+	while(done < maxBatches){
+		run(p, done, done+round, s+done);
+		//combine batches in order
+		for(long b=done; b<done+round; b++){
+			double n = (double)b*MC_BATCH, nb = MC_BATCH;
+			double delta = s[b].mean - mean;
+			mean += delta*nb/(n+nb);
+			m2 += s[b].m2 + delta*delta*n*nb/(n+nb);
+		}
+		done += round;
+		r.rounds++;
+		double n = (double)done*MC_BATCH;
+		double var = m2/(n-1);
+		r.stdError = sqrt(var/n);
+		if(targetError > 0 && r.stdError <= targetError){
+			r.converged = 1;
+			break;
+		}
+		//batches to reach target, at most twice those done
+		long next = done;
+		if(targetError > 0){
+			double need = ceil(var/(targetError*targetError)/MC_BATCH) - done;
+			if(need < next)
+				next = need < 1 ? 1 : need;
+		}
+		round = next < maxBatches-done ? next : maxBatches-done;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &tend);
+	r.time = (tend.tv_sec-tstart.tv_sec) + (tend.tv_nsec-tstart.tv_nsec)*1.0e-9;
+	r.estimate = mean;
+	r.samples = done*MC_BATCH;
+	free(s);
+	return r;
+}
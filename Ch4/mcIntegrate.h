@@ -0,0 +1,54 @@
+// Parallel Monte Carlo integration over the unit cube [0,1)^dim,
+// generalizing the pi programs to any integrand, used by integrateMC.c.
+// Points are generated in batches of MC_BATCH. Batch b uses Philox
+// stream b (see philox.h), and coordinate j of point i of the batch is
+// made from word dim*i+j, so the points don't depend on how batches are
+// divided among threads, tasks or processes.
+// Integration proceeds in rounds of batches. Each batch gives the mean
+// and sum of squared deviations of its integrand values, and these are
+// combined in batch order (Chan, Golub and LeVeque's pairwise formula)
+// after each round, so results are bit-identical for every back end and
+// number of threads or processes. After a round, integration stops if
+// the standard error is at most the target error. Otherwise the next
+// round is sized from the variance to just reach the target, but at
+// most doubles the number of batches, which stops within about one
+// round of the samples needed.
+// Back ends:
+//   MC_OPENMP: loop over batches with OpenMP (compile with -fopenmp)
+//   MC_FORKJOIN: recursive fork-join with workSteal.h (call wsInit first)
+//   MC_MPI: batches divided cyclically among processes (compile with
+//           mpicc -DUSE_MPI, and call mcIntegrate in every process)
+#ifndef MCINTEGRATE_H
+#define MCINTEGRATE_H
+#include <stdint.h>
+#define MC_BATCH 4096 //points per batch
+#define MC_FIRST_ROUND 16 //batches in first round
+
+// integrand at point x in [0,1)^dim
+typedef double (*Integrand)(const double *x, int dim, void *params);
+typedef struct{
+	Integrand f;
+	int dim;
+	void *params; //passed to f
+	uint64_t seed; //of random numbers
+} McProblem;
+typedef struct{
+	double estimate;
+	double stdError;
+	long samples;
+	int rounds;
+	int converged; //1 if stdError reached target
+	double time; //in s
+} McResult;
+enum McBackend {MC_OPENMP, MC_FORKJOIN, MC_MPI, MC_NUM_BACKENDS};
+
+// name of back end
+const char *mcBackendName(enum McBackend b);
+// 1 if back end was compiled in
+int mcBackendAvailable(enum McBackend b);
+// integrates p->f with up to maxSamples points (rounded up to whole
+// batches), stopping early when standard error <= targetError (no
+// early stopping if targetError <= 0)
+McResult mcIntegrate(const McProblem *p, enum McBackend b, long maxSamples,
+		double targetError);
+#endif
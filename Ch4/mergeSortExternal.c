@@ -0,0 +1,463 @@
+/* Copyright 2017 Eric Aubanel
+ * This file contains code extending Algorithms 3.2, 3.3 and 4.13 from
+ * Elements of Parallel Computing, by Eric Aubanel, 2016, CRC Press.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------
+ * External (out-of-core) merge sort of a binary file of int32_t keys,
+ * using at most about mem MB of memory, so files larger than memory
+ * can be sorted.
+ * 1. Run formation: the file is read in runs of mem/2 MB, each run
+ *    is sorted by the parallel merge sort of mergeSortGeneric.h (which
+ *    needs a work array, hence mem/2), and written to a temporary file.
+ * 2. Merge: the k runs are merged with a loser tree, a binary tree
+ *    whose internal nodes hold the run that lost the comparison there,
+ *    so replacing the winner takes log2(k) comparisons on a path to the
+ *    root. The memory is divided into 2 buffers for each run and 2 for
+ *    the output. While one buffer is merged, the other is read (or
+ *    written) with asynchronous POSIX I/O (like pread and pwrite).
+ *    Buffers have at least MIN_BUFFER keys, so if there are too many
+ *    runs for mem, groups of runs are merged in extra passes through
+ *    a second temporary file, until few enough runs are left.
+ * Outputs the time and I/O throughput of each phase, and the time the
+ * merge waited for I/O. Verifies that the output is sorted and has the
+ * same checksums as the input.
+ * Use -g to generate a file of n random keys.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <aio.h>
+#include <sys/stat.h>
+#include "mergeSortGeneric.h"
+
+#define MIN_BUFFER 16384 //minimum keys in run and merge buffers
+
+//run being merged, read with double buffering
+typedef struct{
+	int32_t *buf[2];
+	struct aiocb cb[2]; //read into each buffer
+	off_t next; //file offset of next read
+	off_t end; //file offset of end of run
+	int cur; //buffer being merged
+	long len; //keys in current buffer
+	long pos; //position in current buffer
+} Run;
+
+//output written with double buffering
+typedef struct{
+	int32_t *buf[2];
+	struct aiocb cb[2];
+	int pending[2]; //write of buffer in progress
+	off_t next; //file offset of next write
+	int cur; //buffer being filled
+	long len; //keys in current buffer
+	long size; //capacity of buffer
+} Output;
+
+//read (write) n bytes at offset of file, returns 0 if successful
+int readFull(int fd, void *buf, size_t n, off_t offset);
+int writeFull(int fd, const void *buf, size_t n, off_t offset);
+//start asynchronous read of next part of run into buffer i
+void startRead(Run *r, int i, int fd, long size);
+//wait for asynchronous I/O, adding time waited to wait, returns bytes
+//transferred, or exits if error
+long waitIO(struct aiocb *cb, double *wait);
+//move to next key of run, returns key, or INT64_MAX if run is finished
+int64_t nextKey(Run *r, int fd, long size, double *wait);
+//add key to output, flushing buffer when full
+void put(Output *o, int32_t key, double *wait);
+void flush(Output *o, double *wait);
+//k-way merge of runs of sorted keys of length runLen (last run shorter)
+//starting at key lo and ending before key hi of file fd, into the same
+//keys of file out, using mem bytes, adds checksums of output to sum,
+//returns 1 if output sorted
+int kWayMerge(int fd, long lo, long hi, long runLen, int out, size_t mem,
+		uint64_t sum[2], double *wait);
+//adds sum and sum of squares of keys to sum, for verification
+void checksum(const int32_t *a, long m, uint64_t sum[2]);
+//write file of n random keys
+int generate(const char *name, long n, unsigned seed);
+//time in seconds since t
+double elapsed(struct timespec t);
+
+int main(int argc, char **argv){
+	if(argc > 3 && !strcmp(argv[1], "-g"))
+		return generate(argv[3], strtol(argv[2], NULL, 10),
+				argc > 4 ? strtol(argv[4], NULL, 10) : time(NULL));
+	if(argc < 4){
+		fprintf(stderr,"usage: %s input output mem\n", argv[0]);
+		fprintf(stderr,"       %s -g n file [seed]\n", argv[0]);
+		fprintf(stderr,"mem is memory to use in MB, files have binary 32-bit keys\n");
+		return 1;
+	}
+	size_t mem = strtol(argv[3], NULL, 10) << 20;
+	int in = open(argv[1], O_RDONLY);
+	struct stat st;
+	if(in < 0 || fstat(in, &st) || st.st_size % sizeof(int32_t)){
+		fprintf(stderr,"can't read file %s of 32-bit keys\n", argv[1]);
+		return 1;
+	}
+	long n = st.st_size/sizeof(int32_t);
+	char *runName = malloc(strlen(argv[2]) + 6);
+	char *passName = malloc(strlen(argv[2]) + 6);
+	sprintf(runName, "%s.runs", argv[2]);
+	sprintf(passName, "%s.pass", argv[2]);
+	int runs = open(runName, O_RDWR | O_CREAT | O_TRUNC, 0600);
+	int pass = open(passName, O_RDWR | O_CREAT | O_TRUNC, 0600);
+	int out = open(argv[2], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(runs < 0 || pass < 0 || out < 0){
+		fprintf(stderr,"can't create files %s, %s and %s\n", argv[2], runName,
+				passName);
+		return 1;
+	}
+	unlink(runName); //removed when closed
+	unlink(passName);
+	long runLen = mem/(2*sizeof(int32_t)); //keys per run
+	if(runLen > n)
+		runLen = n;
+	//most runs merged at once, with 2 buffers of MIN_BUFFER for each
+	//run and for output
+	long maxWay = mem/(2*MIN_BUFFER*sizeof(int32_t)) - 1;
+	if((runLen < MIN_BUFFER || maxWay < 2) && runLen < n){
+		fprintf(stderr,"mem too small\n");
+		return 1;
+	}
+	int k = n > 0 ? (n + runLen - 1)/runLen : 0; //number of runs
+	int32_t *a = malloc((runLen > 0 ? runLen : 1)*sizeof(int32_t));
+	int32_t *b = malloc((runLen > 0 ? runLen : 1)*sizeof(int32_t));
+	if(!a || !b){
+		fprintf(stderr,"couldn't allocate memory\n");
+		return 1;
+	}
+
+	//1. run formation
+	uint64_t sumIn[2] = {0, 0}, sumOut[2];
+	double readTime = 0, sortTime = 0, writeTime = 0;
+	struct timespec tstart, t;
+	clock_gettime(CLOCK_MONOTONIC, &tstart);
+	for(int r=0; r<k; r++){
+		long m = runLen < n - r*runLen ? runLen : n - r*runLen;
+		off_t offset = r*runLen*sizeof(int32_t);
+		clock_gettime(CLOCK_MONOTONIC, &t);
+		if(readFull(in, a, m*sizeof(int32_t), offset)){
+			fprintf(stderr,"can't read %s\n", argv[1]);
+			return 1;
+		}
+		readTime += elapsed(t);
+		clock_gettime(CLOCK_MONOTONIC, &t);
+		checksum(a, m, sumIn);
+		mergeSortGeneric(a, b, m);
+		sortTime += elapsed(t);
+		clock_gettime(CLOCK_MONOTONIC, &t);
+		if(writeFull(runs, a, m*sizeof(int32_t), offset)){
+			fprintf(stderr,"can't write %s\n", runName);
+			return 1;
+		}
+		writeTime += elapsed(t);
+	}
+	double runTime = elapsed(tstart);
+	free(a);
+	free(b);
+	close(in);
+	double mb = n*sizeof(int32_t)/1e6; //size of file in MB
+	printf("%ld keys (%.1f MB), %d threads, %zu MB memory\n", n, mb,
+			genericNumThreads(), mem >> 20);
+	printf("run formation: %d runs, time in s: %f\n", k, runTime);
+	printf("  read %.1f MB/s, sort %f s, write %.1f MB/s\n", mb/readTime,
+			sortTime, mb/writeTime);
+
+	//2. merge, in passes of groups of up to maxWay runs until 1 run left
+	double wait = 0;
+	int passes = 0, sorted = 1;
+	clock_gettime(CLOCK_MONOTONIC, &tstart);
+	for(; runLen < n; runLen *= maxWay){
+		long k = (n + runLen - 1)/runLen;
+		long group = k > maxWay ? maxWay*runLen : n; //keys merged at once
+		int to = k > maxWay ? pass : out;
+		sumOut[0] = sumOut[1] = 0;
+		for(long lo=0; lo<n; lo+=group){
+			long hi = lo+group < n ? lo+group : n;
+			sorted = kWayMerge(runs, lo, hi, runLen, to, mem, sumOut, &wait);
+		}
+		passes++;
+		int tmp = runs;
+		runs = pass;
+		pass = tmp;
+	}
+	if(passes == 0){
+		//single run, copy to output
+		sumOut[0] = sumOut[1] = 0;
+		sorted = kWayMerge(runs, 0, n, n > 0 ? n : 1, out, mem, sumOut, &wait);
+		passes = n > 0;
+	}
+	double mergeTime = elapsed(tstart);
+	close(out);
+	close(runs);
+	close(pass);
+	printf("merge: %d passes of up to %ld-way merges, time in s: %f\n",
+			passes, maxWay, mergeTime);
+	printf("  read and write %.1f MB/s, waited for I/O %f s\n",
+			2*mb*passes/mergeTime, wait);
+	printf("total time in s: %f\n", runTime + mergeTime);
+	if(sorted && sumIn[0] == sumOut[0] && sumIn[1] == sumOut[1])
+		printf("result verified\n");
+	else
+		printf("result not sorted, or keys differ from input keys\n");
+	return 0;
+}
+
+int kWayMerge(int fd, long lo, long hi, long runLen, int out, size_t mem,
+		uint64_t sum[2], double *wait){
+	long n = hi - lo;
+	int k = n > 0 ? (n + runLen - 1)/runLen : 0;
+	if(k == 0)
+		return 1;
+	//2 buffers for each run and for output, at least MIN_BUFFER keys as
+	//k <= maxWay (or a single run)
+	long size = mem/(2*(k+1)*sizeof(int32_t));
+	Run *run = malloc(k*sizeof(Run));
+	int64_t *key = malloc(k*sizeof(int64_t)); //current key of each run
+	int *tree = malloc(k*sizeof(int)); //loser tree, winner in tree[0]
+	Output o = {.size = size, .next = lo*sizeof(int32_t)};
+	if(!run || !key || !tree){
+		fprintf(stderr,"couldn't allocate memory\n");
+		exit(1);
+	}
+	for(int i=0; i<2; i++){
+		o.buf[i] = malloc(size*sizeof(int32_t));
+		memset(&o.cb[i], 0, sizeof(o.cb[i]));
+		o.cb[i].aio_fildes = out;
+		o.pending[i] = 0;
+		if(!o.buf[i]){
+			fprintf(stderr,"couldn't allocate memory\n");
+			exit(1);
+		}
+	}
+	for(int r=0; r<k; r++){
+		Run *p = run+r;
+		p->next = (lo + r*runLen)*sizeof(int32_t);
+		p->end = (r < k-1 ? lo + (r+1)*runLen : hi)*sizeof(int32_t);
+		for(int i=0; i<2; i++){
+			p->buf[i] = malloc(size*sizeof(int32_t));
+			if(!p->buf[i]){
+				fprintf(stderr,"couldn't allocate memory\n");
+				exit(1);
+			}
+			startRead(p, i, fd, size);
+		}
+		p->cur = 1;
+		p->len = p->pos = 0;
+		key[r] = nextKey(p, fd, size, wait);
+	}
+	//a run is less than another if its key is less, or equal with lower
+	//index, finished runs have key INT64_MAX
+	#define LESS(i, j) (key[i] < key[j] || (key[i] == key[j] && (i) < (j)))
+	//build tree: node t has children 2t and 2t+1, run r is node k+r
+	tree[0] = 0;
+	for(int t=1; t<k; t++)
+		tree[t] = -1;
+	for(int r=0; r<k; r++){
+		int w = r; //winner moving up tree
+		int t = (k+r)/2;
+		for(; t>0; t/=2){
+			if(tree[t] < 0){
+				//wait for other subtree to reach this node
+				tree[t] = w;
+				break;
+			}
+			if(LESS(tree[t], w)){
+				int temp = tree[t];
+				tree[t] = w;
+				w = temp;
+			}
+		}
+		if(t == 0)
+			tree[0] = w;
+	}
+	int sorted = 1;
+	int64_t last = INT64_MIN;
+	for(long i=0; i<n; i++){
+		int w = tree[0];
+		int32_t x = key[w];
+		sorted &= x >= last;
+		last = x;
+		checksum(&x, 1, sum);
+		put(&o, x, wait);
+		key[w] = nextKey(run+w, fd, size, wait);
+		for(int t=(k+w)/2; t>0; t/=2)
+			if(LESS(tree[t], w)){
+				int temp = tree[t];
+				tree[t] = w;
+				w = temp;
+			}
+		tree[0] = w;
+	}
+	#undef LESS
+	flush(&o, wait);
+	for(int i=0; i<2; i++)
+		if(o.pending[i])
+			waitIO(&o.cb[i], wait);
+	for(int i=0; i<2; i++)
+		free(o.buf[i]);
+	for(int r=0; r<k; r++){
+		free(run[r].buf[0]);
+		free(run[r].buf[1]);
+	}
+	free(run);
+	free(key);
+	free(tree);
+	return sorted;
+}
+
+void startRead(Run *r, int i, int fd, long size){
+	struct aiocb *cb = &r->cb[i];
+	memset(cb, 0, sizeof(*cb));
+	cb->aio_fildes = fd;
+	cb->aio_buf = r->buf[i];
+	cb->aio_offset = r->next;
+	cb->aio_nbytes = r->end - r->next < (off_t)(size*sizeof(int32_t))
+			? r->end - r->next : (off_t)(size*sizeof(int32_t));
+	r->next += cb->aio_nbytes;
+	if(cb->aio_nbytes && aio_read(cb)){
+		perror("aio_read");
+		exit(1);
+	}
+}
+
+long waitIO(struct aiocb *cb, double *wait){
+	if(cb->aio_nbytes == 0)
+		return 0;
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	const struct aiocb *list[1] = {cb};
+	int err;
+	while((err = aio_error(cb)) == EINPROGRESS)
+		aio_suspend(list, 1, NULL);
+	*wait += elapsed(t);
+	long bytes = aio_return(cb);
+	if(err || bytes != (long)cb->aio_nbytes){
+		fprintf(stderr,"asynchronous I/O failed: %s\n", strerror(err));
+		exit(1);
+	}
+	return bytes;
+}
+
+int64_t nextKey(Run *r, int fd, long size, double *wait){
+	if(r->pos == r->len){
+		//refill buffer just merged, and switch to other buffer
+		if(r->len > 0)
+			startRead(r, r->cur, fd, size);
+		r->cur ^= 1;
+		r->len = waitIO(&r->cb[r->cur], wait)/sizeof(int32_t);
+		r->pos = 0;
+		if(r->len == 0)
+			return INT64_MAX;
+	}
+	return r->buf[r->cur][r->pos++];
+}
+
+void put(Output *o, int32_t key, double *wait){
+	o->buf[o->cur][o->len++] = key;
+	if(o->len == o->size)
+		flush(o, wait);
+}
+
+void flush(Output *o, double *wait){
+	if(o->len == 0)
+		return;
+	struct aiocb *cb = &o->cb[o->cur];
+	cb->aio_buf = o->buf[o->cur];
+	cb->aio_offset = o->next;
+	cb->aio_nbytes = o->len*sizeof(int32_t);
+	if(aio_write(cb)){
+		perror("aio_write");
+		exit(1);
+	}
+	o->pending[o->cur] = 1;
+	o->next += cb->aio_nbytes;
+	o->len = 0;
+	//fill other buffer when its write is done
+	o->cur ^= 1;
+	if(o->pending[o->cur]){
+		waitIO(&o->cb[o->cur], wait);
+		o->pending[o->cur] = 0;
+	}
+}
+
+int readFull(int fd, void *buf, size_t n, off_t offset){
+	while(n > 0){
+		ssize_t r = pread(fd, buf, n, offset);
+		if(r <= 0)
+			return 1;
+		buf = (char *)buf + r;
+		n -= r;
+		offset += r;
+	}
+	return 0;
+}
+
+int writeFull(int fd, const void *buf, size_t n, off_t offset){
+	while(n > 0){
+		ssize_t r = pwrite(fd, buf, n, offset);
+		if(r <= 0)
+			return 1;
+		buf = (const char *)buf + r;
+		n -= r;
+		offset += r;
+	}
+	return 0;
+}
+
+void checksum(const int32_t *a, long m, uint64_t sum[2]){
+	for(long i=0; i<m; i++){
+		uint64_t x = (uint32_t)a[i];
+		sum[0] += x;
+		sum[1] += x*x;
+	}
+}
+
+int generate(const char *name, long n, unsigned seed){
+	FILE *f = fopen(name, "wb");
+	if(f == NULL || n < 0){
+		fprintf(stderr,"can't write file %s of n keys\n", name);
+		return 1;
+	}
+	srand(seed);
+	int32_t buf[4096];
+	for(long i=0; i<n; i+=4096){
+		long m = n-i < 4096 ? n-i : 4096;
+		for(long j=0; j<m; j++)
+			buf[j] = rand() - RAND_MAX/2;
+		fwrite(buf, sizeof(int32_t), m, f);
+	}
+	if(fclose(f)){
+		fprintf(stderr,"couldn't write file %s\n", name);
+		return 1;
+	}
+	return 0;
+}
+
+double elapsed(struct timespec t){
+	struct timespec tend;
+	clock_gettime(CLOCK_MONOTONIC, &tend);
+	return (tend.tv_sec-t.tv_sec) + (tend.tv_nsec-t.tv_nsec)*1.0e-9;
+}
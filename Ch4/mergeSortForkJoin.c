@@ -16,24 +16,37 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  *
  * -------------------------------------------------------------------
- * Fork-join merge sort, using Cilk Plus. 
+ * Fork-join merge sort, using the work-stealing runtime of workSteal.h
+ * (in place of Cilk Plus). Number of workers is given by environment
+ * variable WS_NUM_WORKERS (default number of cores).
+ * If cutoff isn't given it is found by calibration trials, or from a
+ * previous calibration saved in a profile file (see cutoffTuner.h)
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
-#include <cilk/cilk.h>
-#include <cilk/cilk_api.h>
+#include "workSteal.h"
+#include "cutoffTuner.h"
 
 /*sort elements of a with index i in [lower .. upper) into array b
- * in parallel using Cilk Plus
+ * in parallel using work-stealing tasks
  * array a is modified
  */
 void parMergeSort(int *a, int lower, int upper, int *b);
-//parallel merge using Cilk Plus of sorted subarrays
+//parallel merge using work-stealing tasks of sorted subarrays
 // i in [low1..up1) and i in [low2..up2) at index start
 void parMerge(int *a, int low1, int up1, int low2, int up2, int *b, int start);
+//arguments of parMergeSort and parMerge as tasks
+typedef struct{
+	int *a, lower, upper, *b;
+} SortArgs;
+typedef struct{
+	int *a, low1, up1, low2, up2, *b, start;
+} MergeArgs;
+void parMergeSortTask(void *arg);
+void parMergeTask(void *arg);
 //first index in [low..up) such that a[index] > a[ikey]
 int binarySearch(int *a, int low, int up, int ikey);
 //merge a[low1 .. up1) and a[low2 .. up2) into b at index start
@@ -44,6 +57,8 @@ int comparefunc(const void * arg1, const void * arg2);
 void mergeSort(int *a, int lower, int upper, int *b);
 //merge a[lower .. mid) and a[mid .. upper) into b
 void merge(int *a, int lower, int mid, int upper, int *b);
+//time of parMergeSort of n random ints with cutoff c, used by tuneCutoff
+double trialSort(long n, int c);
 
 int cutoff; //cutoff for recursion
 
@@ -56,12 +71,17 @@ int main(int argc, char **argv){
 	struct timespec tstart,tend; 
   float timer;
 
-	if(argc <3){
-		fprintf(stderr,"usage: %s n cutoff\n", argv[0]);
+	if(argc <2){
+		fprintf(stderr,"usage: %s n [cutoff]\n", argv[0]);
 		return 1;
 	}
 	n = strtol(argv[1], NULL, 10);
-	cutoff = strtol(argv[2], NULL, 10);
+	cutoff = argc > 2 ? strtol(argv[2], NULL, 10) : 0;
+	wsInit(0);
+	if(cutoff <= 0){
+		cutoff = tuneCutoff("mergeSortForkJoin", n, wsNumWorkers(), trialSort);
+		wsResetStats();
+	}
 	a = malloc(n*sizeof(int));
 	b = malloc(n*sizeof(int));
 	bs = malloc(n*sizeof(int));
@@ -85,11 +105,13 @@ int main(int argc, char **argv){
 	//parallel sort
 	clock_gettime(CLOCK_MONOTONIC, &tstart);
 	memcpy(b, a, n*sizeof(int));
-	parMergeSort(a, 0, n, b);
+	SortArgs args = {a, 0, n, b};
+	wsRun(parMergeSortTask, &args);
 	clock_gettime(CLOCK_MONOTONIC, &tend);
   timer = (tend.tv_sec-tstart.tv_sec) +
         (tend.tv_nsec-tstart.tv_nsec)*1.0e-9;
-	printf("parallel time in s: %f\n", timer);
+	printf("parallel time in s, using %d workers: %f\n", wsNumWorkers(), timer);
+	wsPrintStats(stdout);
 
 	int passed = 1;
 	for(int i=0; i<n; i++)
@@ -99,6 +121,7 @@ int main(int argc, char **argv){
 		}
 	if(passed)
 		printf("result verified\n");
+	wsFinalize();
   return 0;
 }
 
@@ -107,9 +130,12 @@ void parMergeSort(int *a, int lower, int upper, int *b){
 		mergeSort(a, lower, upper, b);
 	else {
 		int mid = (upper + lower)/2;
-		cilk_spawn parMergeSort(b, lower, mid, a);
+		SortArgs args = {b, lower, mid, a};
+		WsGroup g = WS_GROUP_INIT;
+		WsTask t;
+		wsSpawn(&g, &t, parMergeSortTask, &args);
 		parMergeSort(b, mid, upper, a);
-		cilk_sync;
+		wsSync(&g);
 		parMerge(a, lower, mid, mid, upper, b, lower);
 	}
 }
@@ -129,13 +155,26 @@ void parMerge(int *a, int low1, int up1, int low2, int up2, int *b, int start){
 			mid1 = binarySearch(a, low1, up1, mid2)-1;
 			mid2++;
 		}
-		cilk_spawn parMerge(a, low1, mid1+1, low2, mid2, b, start);
+		MergeArgs args = {a, low1, mid1+1, low2, mid2, b, start};
+		WsGroup g = WS_GROUP_INIT;
+		WsTask t;
+		wsSpawn(&g, &t, parMergeTask, &args);
 		start = start + mid1 - low1 + 1 + mid2 - low2;
 		parMerge(a, mid1+1, up1, mid2, up2, b, start);
-		cilk_sync;
+		wsSync(&g);
 	}
 }
 
+void parMergeSortTask(void *arg){
+	SortArgs *s = arg;
+	parMergeSort(s->a, s->lower, s->upper, s->b);
+}
+
+void parMergeTask(void *arg){
+	MergeArgs *m = arg;
+	parMerge(m->a, m->low1, m->up1, m->low2, m->up2, m->b, m->start);
+}
+
 int binarySearch(int *a, int low, int up, int ikey){
 	up--; //up now refers to index of last element
 	int key = a[ikey];
@@ -190,3 +229,23 @@ void merge(int *a, int lower, int mid, int upper, int *b){
 		else
 			b[k] = a[j++];
 }
+
+double trialSort(long n, int c){
+	struct timespec tstart,tend;
+	int *a = malloc(n*sizeof(int));
+	int *b = malloc(n*sizeof(int));
+	if(a == NULL || b == NULL){
+		fprintf(stderr,"couldn't allocate array of %ld ints\n", n);
+		exit(1);
+	}
+	for(int i=0; i<n; i++)
+		a[i] = b[i] = rand();
+	SortArgs args = {a, 0, n, b};
+	cutoff = c;
+	clock_gettime(CLOCK_MONOTONIC, &tstart);
+	wsRun(parMergeSortTask, &args);
+	clock_gettime(CLOCK_MONOTONIC, &tend);
+	free(a);
+	free(b);
+	return (tend.tv_sec-tstart.tv_sec) + (tend.tv_nsec-tstart.tv_nsec)*1.0e-9;
+}
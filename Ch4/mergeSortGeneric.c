@@ -0,0 +1,136 @@
+/* Copyright 2017 Eric Aubanel
+ * This file contains code extending Algorithms 3.2, 3.3 and 4.13 from
+ * Elements of Parallel Computing, by Eric Aubanel, 2016, CRC Press.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------
+ * Times the type-generic stable merge sort of mergeSortGeneric.h on n
+ * random int32_t, int64_t, float and KeyIndex elements, using OpenMP,
+ * and compares with qsort. KeyIndex keys have many duplicates, and index
+ * is the original position, so qsort comparing (key, index) gives the
+ * result of a stable sort, which is used to check stability.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <omp.h>
+#include "mergeSortGeneric.h"
+
+//comparison functions for sequential sort
+int compareInt32(const void *arg1, const void *arg2);
+int compareInt64(const void *arg1, const void *arg2);
+int compareFloat(const void *arg1, const void *arg2);
+int compareKeyIndex(const void *arg1, const void *arg2);
+//time in seconds since t
+double elapsed(struct timespec t);
+
+int main(int argc, char **argv){
+	if(argc < 2){
+		fprintf(stderr,"usage: %s n\n", argv[0]);
+		return 1;
+	}
+	long n = strtol(argv[1], NULL, 10);
+	if(n < 1){
+		fprintf(stderr,"n must be positive\n");
+		return 1;
+	}
+	//arrays with space for n elements of largest type
+	void *a = malloc(n*sizeof(KeyIndex));
+	void *b = malloc(n*sizeof(KeyIndex));
+	void *s = malloc(n*sizeof(KeyIndex)); //for sequential sort
+	if(a == NULL || b == NULL || s == NULL){
+		fprintf(stderr,"couldn't allocate arrays of %ld elements\n", n);
+		return 1;
+	}
+	srand(time(NULL));
+	printf("n = %ld, %d threads\n", n, omp_get_max_threads());
+	printf("%-10s %12s %12s %8s\n", "type", "qsort (s)", "generic (s)",
+			"speedup");
+
+	const char *names[] = {"int32_t", "int64_t", "float", "KeyIndex"};
+	for(int t=0; t<4; t++){
+		size_t size;
+		int (*compare)(const void *, const void *);
+		for(long i=0; i<n; i++)
+			switch(t){
+				case 0: ((int32_t *)a)[i] = rand() - RAND_MAX/2; break;
+				case 1: ((int64_t *)a)[i] = ((int64_t)rand() << 32) ^ rand(); break;
+				case 2: ((float *)a)[i] = rand()/(float)RAND_MAX - 0.5; break;
+				case 3: ((KeyIndex *)a)[i].key = rand()%1000;
+					((KeyIndex *)a)[i].index = i;
+			}
+		switch(t){
+			case 0: size = sizeof(int32_t); compare = compareInt32; break;
+			case 1: size = sizeof(int64_t); compare = compareInt64; break;
+			case 2: size = sizeof(float); compare = compareFloat; break;
+			default: size = sizeof(KeyIndex); compare = compareKeyIndex;
+		}
+		memcpy(s, a, n*size);
+		struct timespec tstart;
+		clock_gettime(CLOCK_MONOTONIC, &tstart);
+		qsort(s, n, size, compare);
+		double qsortTime = elapsed(tstart);
+
+		clock_gettime(CLOCK_MONOTONIC, &tstart);
+		switch(t){
+			case 0: mergeSortGeneric((int32_t *)a, (int32_t *)b, n); break;
+			case 1: mergeSortGeneric((int64_t *)a, (int64_t *)b, n); break;
+			case 2: mergeSortGeneric((float *)a, (float *)b, n); break;
+			case 3: mergeSortGeneric((KeyIndex *)a, (KeyIndex *)b, n); break;
+		}
+		double time = elapsed(tstart);
+		printf("%-10s %12f %12f %8.2f", names[t], qsortTime, time,
+				qsortTime/time);
+		if(memcmp(a, s, n*size))
+			printf("  result differs from qsort\n");
+		else
+			printf("  result verified\n");
+	}
+	return 0;
+}
+
+double elapsed(struct timespec t){
+	struct timespec tend;
+	clock_gettime(CLOCK_MONOTONIC, &tend);
+	return (tend.tv_sec-t.tv_sec) + (tend.tv_nsec-t.tv_nsec)*1.0e-9;
+}
+
+int compareInt32(const void *arg1, const void *arg2){
+	const int32_t x = *(const int32_t *)arg1;
+	const int32_t y = *(const int32_t *)arg2;
+	return (x > y) - (x < y);
+}
+
+int compareInt64(const void *arg1, const void *arg2){
+	const int64_t x = *(const int64_t *)arg1;
+	const int64_t y = *(const int64_t *)arg2;
+	return (x > y) - (x < y);
+}
+
+int compareFloat(const void *arg1, const void *arg2){
+	const float x = *(const float *)arg1;
+	const float y = *(const float *)arg2;
+	return (x > y) - (x < y);
+}
+
+int compareKeyIndex(const void *arg1, const void *arg2){
+	const KeyIndex *x = arg1;
+	const KeyIndex *y = arg2;
+	if(x->key != y->key)
+		return (x->key > y->key) - (x->key < y->key);
+	return (x->index > y->index) - (x->index < y->index);
+}
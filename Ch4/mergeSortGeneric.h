@@ -0,0 +1,152 @@
+// Type-generic stable merge sort, used by mergeSortGeneric.c and
+// mergeSortExternal.c. mergeSortGeneric(a, b, n) sorts array a of n
+// elements, using work array b of n elements, where a is one of:
+//   int32_t *, int64_t *, float * (no NaNs), KeyIndex *
+// KeyIndex records are sorted by key only, and equal keys stay in their
+// original order, so index can be a payload or the original position.
+// The _Generic selection chooses a version of the sort written for each
+// type, so comparisons are inlined rather than done by a function call.
+// Sorts in parallel with OpenMP (if compiled with OpenMP), like
+// parMergeSort in mergeSortOMPSPMD.c: each thread sorts its chunk, and
+// chunks are merged in pairs, each thread producing an equal part of
+// the merged output, found by co-rank binary search.
+#ifndef MERGESORTGENERIC_H
+#define MERGESORTGENERIC_H
+#include <stdint.h>
+#include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+typedef struct{
+	int64_t key;
+	int64_t index;
+} KeyIndex;
+
+#define GENERIC_RUN 16 //runs sorted by insertion sort
+#define GENERIC_CHUNK 4096 //minimum elements per thread
+
+static inline int genericNumThreads(void){
+	#ifdef _OPENMP
+	return omp_get_max_threads();
+	#else
+	return 1;
+	#endif
+}
+
+static inline int genericThreadNum(void){
+	#ifdef _OPENMP
+	return omp_get_thread_num();
+	#else
+	return 0;
+	#endif
+}
+
+// Defines functions for elements of type T, compared with LESS(x, y),
+// with names ending in S:
+// mergeRunsS merges A[0..na) and B[0..nb) into C, taking from A if equal
+// coRankS returns i such that first k elements of merge of A[0..na) and
+// B[0..nb) are A[0..i) and B[0..k-i)
+// bottomUpS sorts a[0..n) using b as work array, result in a
+// mergeSortS sorts a[0..n) in parallel using b as work array, result in a
+#define DEFINE_GENERIC_SORT(T, S, LESS) \
+static inline void mergeRuns##S(const T *A, long na, const T *B, long nb, T *C){ \
+	long i = 0, j = 0, k = 0; \
+	while(i < na && j < nb){ \
+		if(LESS(B[j], A[i])) \
+			C[k++] = B[j++]; \
+		else \
+			C[k++] = A[i++]; \
+	} \
+	memcpy(C+k, A+i, (na-i)*sizeof(T)); \
+	memcpy(C+k+na-i, B+j, (nb-j)*sizeof(T)); \
+} \
+\
+static inline long coRank##S(long k, const T *A, long na, const T *B, long nb){ \
+	long lo = k > nb ? k-nb : 0; \
+	long hi = k < na ? k : na; \
+	while(lo < hi){ \
+		long i = lo + (hi-lo)/2; \
+		long j = k-i; \
+		if(j > 0 && !LESS(B[j-1], A[i])) \
+			lo = i+1; \
+		else \
+			hi = i; \
+	} \
+	return lo; \
+} \
+\
+static inline void bottomUp##S(T *a, T *b, long n){ \
+	for(long lo=0; lo<n; lo+=GENERIC_RUN){ \
+		long hi = lo+GENERIC_RUN < n ? lo+GENERIC_RUN : n; \
+		for(long i=lo+1; i<hi; i++){ \
+			T x = a[i]; \
+			long j = i; \
+			for(; j>lo && LESS(x, a[j-1]); j--) \
+				a[j] = a[j-1]; \
+			a[j] = x; \
+		} \
+	} \
+	T *from = a, *to = b; \
+	for(long w=GENERIC_RUN; w<n; w*=2){ \
+		for(long lo=0; lo<n; lo+=2*w){ \
+			long mid = lo+w < n ? lo+w : n; \
+			long hi = lo+2*w < n ? lo+2*w : n; \
+			mergeRuns##S(from+lo, mid-lo, from+mid, hi-mid, to+lo); \
+		} \
+		T *t = from; from = to; to = t; \
+	} \
+	if(from != a) \
+		memcpy(a, from, n*sizeof(T)); \
+} \
+\
+static inline void mergeSort##S(T *a, T *b, long n){ \
+	int nt = genericNumThreads(); \
+	if(nt > n/GENERIC_CHUNK) \
+		nt = n/GENERIC_CHUNK > 0 ? n/GENERIC_CHUNK : 1; \
+	_Pragma("omp parallel num_threads(nt)") \
+	{ \
+		int id = genericThreadNum(); \
+		long lower = id*n/nt; \
+		long upper = (id+1)*n/nt; \
+		T *from = a, *to = b; \
+		bottomUp##S(a+lower, b+lower, upper-lower); \
+		for(int w=1; w<nt; w*=2){ \
+			_Pragma("omp barrier") \
+			for(int g=0; g<nt; g+=2*w){ \
+				long s0 = g*n/nt; \
+				long s1 = (g+w < nt ? g+w : nt)*n/nt; \
+				long s2 = (g+2*w < nt ? g+2*w : nt)*n/nt; \
+				long k0 = lower > s0 ? lower : s0; \
+				long k1 = upper < s2 ? upper : s2; \
+				if(k0 >= k1) \
+					continue; \
+				long i0 = coRank##S(k0-s0, from+s0, s1-s0, from+s1, s2-s1); \
+				long i1 = coRank##S(k1-s0, from+s0, s1-s0, from+s1, s2-s1); \
+				mergeRuns##S(from+s0+i0, i1-i0, from+s1+(k0-s0-i0), \
+						(k1-k0)-(i1-i0), to+k0); \
+			} \
+			T *t = from; from = to; to = t; \
+		} \
+		/* if result is in b, last round read from a, so all threads must \
+		 * finish it before a is overwritten */ \
+		if(from != a){ \
+			_Pragma("omp barrier") \
+			memcpy(a+lower, from+lower, (upper-lower)*sizeof(T)); \
+		} \
+	} \
+}
+
+#define GENERIC_LESS(x, y) ((x) < (y))
+#define GENERIC_LESS_KEY(x, y) ((x).key < (y).key)
+DEFINE_GENERIC_SORT(int32_t, Int32, GENERIC_LESS)
+DEFINE_GENERIC_SORT(int64_t, Int64, GENERIC_LESS)
+DEFINE_GENERIC_SORT(float, Float, GENERIC_LESS)
+DEFINE_GENERIC_SORT(KeyIndex, KeyIndex, GENERIC_LESS_KEY)
+
+#define mergeSortGeneric(a, b, n) _Generic((a), \
+		int32_t *: mergeSortInt32, \
+		int64_t *: mergeSortInt64, \
+		float *: mergeSortFloat, \
+		KeyIndex *: mergeSortKeyIndex)(a, b, n)
+#endif
@@ -16,8 +16,11 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  *
  * -------------------------------------------------------------------
- * Merge sort of n ints, using SPMD style OpenMP with nt threads,
- * where n mod nt = 0 and nt = 2^j 
+ * Merge sort of n ints, using SPMD style OpenMP with any number of
+ * threads nt and any n. Sorted chunks of threads are merged in pairs in
+ * ceil(log2(nt)) rounds. In each round the threads of a group divide the
+ * output of the merge evenly, finding where their output starts in the 2
+ * sorted chunks by binary search along the merge path (co-rank).
  */
 
 #include <stdio.h>
@@ -28,18 +31,17 @@
 #include <omp.h>
 
 //parallel merge sort using SPMD style Openmp (nt threads)
-//where n mod nt = 0 and nt must be a power of 2
 //b is initialized with values of a
 //returns pointer to sorted array
 int *parMergeSort(int *a, int *b, int n);
-//nmt threads merge a[low1..low2) with a[low2..up2] into b at index low1
-void spmdMerge(int *a, int low1, int low2, int up2, int *b, int n, int nmt, int id, int nt);
-//first index in [low..up) such that a[index] > a[ikey]
-int binarySearch(int *a, int low, int up, int ikey);
+//nmt threads merge a[low1..low2) with a[low2..up2) into b at index low1,
+//thread idm of nmt merges elements [idm*len/nmt..(idm+1)*len/nmt) of output
+void spmdMerge(int *a, int low1, int low2, int up2, int *b, int nmt, int idm);
+//returns index i such that the first k elements of the merge of
+//a[low1..up1) and a[low2..up2) are a[low1..i) and a[low2..low2+k-(i-low1))
+int coRank(int *a, int k, int low1, int up1, int low2, int up2);
 //merge a[low1 .. up1) and a[low2 .. up2) into b at index start
 void sequentialMerge(int *a, int low1, int up1, int low2, int up2, int *b, int start);
-//returns 1 if n is a power of 2, 0 otherwise
-int isPowerOf2(int n);
 //swap two int* pointers
 void swap(int **a, int **b);
 //comparison function for sequential sort
@@ -64,15 +66,6 @@ int main(int argc, char **argv){
 		return 1;
 	}
 	n = strtol(argv[1], NULL, 10);
-	int nt = omp_get_max_threads();
-	if(!isPowerOf2(nt)){
-		fprintf(stderr, "must have power of 2 number of threads\n");
-		return 1;
-	}
-	if(n%nt != 0){
-		fprintf(stderr, "%d must be divisible by number of threads\n", n);
-		return 1;
-	}
 	a = malloc(n*sizeof(int));
 	b = malloc(n*sizeof(int));
 	bs = malloc(n*sizeof(int));
@@ -115,28 +108,30 @@ int main(int argc, char **argv){
 
 int *parMergeSort(int *a, int *b, int n){
 	int nt = omp_get_max_threads();
-	int temp = nt;
-	int lognt = 0;
-	while(temp >>= 1)
+	int lognt = 0; //ceil(log2(nt))
+	while((1 << lognt) < nt)
 		lognt++;
 	#pragma omp parallel firstprivate(a, b) 
 	{
 		int id = omp_get_thread_num();
-		int lower = id*n/nt;
-		int upper = (id+1)*n/nt;
+		int lower = (long)id*n/nt;
+		int upper = (long)(id+1)*n/nt;
 		//each thread sorts its chunk
 		mergeSort(a, lower, upper, b);
 		#pragma omp barrier
 		int nmt = 1;
 		for(int i=1; i<=lognt; i++){
 			swap(&a, &b);
-			int chunk = nmt*n/nt;
+			int half = nmt;
 			nmt *= 2;
+			//group of threads idc..idc+nmt-1 (fewer in last group)
 			int idc = (id/nmt)*nmt;
-			int low1 = idc*n/nt;
-			int low2 = low1 + chunk;
-			int up2 = low2 + chunk - 1;
-			spmdMerge(a, low1, low2, up2, b, n, nmt, id, nt);
+			int mid = idc+half < nt ? idc+half : nt;
+			int end = idc+nmt < nt ? idc+nmt : nt;
+			int low1 = (long)idc*n/nt;
+			int low2 = (long)mid*n/nt;
+			int up2 = (long)end*n/nt;
+			spmdMerge(a, low1, low2, up2, b, end-idc, id-idc);
 			#pragma omp barrier
 		}
 	}
@@ -146,41 +141,31 @@ int *parMergeSort(int *a, int *b, int n){
 		return b;
 }
 
-void spmdMerge(int *a, int low1, int low2, int up2, int *b, int n, int nmt, int id, int nt){
-	int idm = id%nmt;
-	int lowX = idm*n/(2*nt) + low1;
-	int upX = (idm+1)*n/(2*nt) + low1 - 1;
-	int lowY, upY;
-	if(idm != 0)
-		lowY = binarySearch(a, low2, up2+1, lowX-1);
-	else
-		lowY = low2;
-	if(idm < nmt-1)
-		upY = binarySearch(a, lowY, up2+1, upX) - 1;
-	else
-		upY = up2;
-	int start = lowX + lowY - low2;
-	sequentialMerge(a, lowX, upX+1, lowY, upY+1, b, start);
+void spmdMerge(int *a, int low1, int low2, int up2, int *b, int nmt, int idm){
+	int len = up2-low1;
+	int k1 = (long)idm*len/nmt;
+	int k2 = (long)(idm+1)*len/nmt;
+	int lowX = coRank(a, k1, low1, low2, low2, up2);
+	int upX = coRank(a, k2, low1, low2, low2, up2);
+	int lowY = low2 + k1 - (lowX-low1);
+	int upY = low2 + k2 - (upX-low1);
+	sequentialMerge(a, lowX, upX, lowY, upY, b, low1+k1);
 }
 
-int binarySearch(int *a, int low, int up, int ikey){
-	up--; //up now refers to index of last element
-	int key = a[ikey];
-	while(low <= up){
-		int mid = (low+up)/2;
-		if(a[mid] == key)
-			low = mid+1;
-		else if (a[mid] > key)
-			up = mid-1;
+int coRank(int *a, int k, int low1, int up1, int low2, int up2){
+	//i-low1 elements from first array, k-(i-low1) from second
+	int lo = k > up2-low2 ? low1 + k-(up2-low2) : low1;
+	int hi = k < up1-low1 ? low1 + k : up1;
+	while(lo < hi){
+		int i = lo + (hi-lo)/2;
+		int j = low2 + k-(i-low1);
+		//merge takes a[i] before a[j-1] if a[i] <= a[j-1]
+		if(j > low2 && a[j-1] >= a[i])
+			lo = i+1;
 		else
-			low = mid+1;
+			hi = i;
 	}
-	if(up < low)
-		return low;
-	else if(a[up] <= key)
-		return up+1;
-	else 	
-		return up;
+	return lo;
 }
 
 void sequentialMerge(int *a, int low1, int up1, int low2, int up2, int *b, int start){
@@ -194,15 +179,6 @@ void sequentialMerge(int *a, int low1, int up1, int low2, int up2, int *b, int s
 	}
 }
 
-int isPowerOf2(int n){
-	while(n){
-		if(n & 1)
-			break;
-		n >>= 1;
-	}
-	return (1 == n? 1:0);
-}
-
 void swap(int **a, int **b){
 	int *temp = *a;
 	*a = *b;
@@ -0,0 +1,563 @@
+/* Copyright 2017 Eric Aubanel
+ * This file contains code extending Algorithms  3.2, 3.3 and 4.13 from
+ * Elements of Parallel Computing, by Eric Aubanel, 2016, CRC Press.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------
+ * Bottom-up merge sort of n ints, with SIMD sorting and merging
+ * networks, using SPMD style OpenMP with any number of threads.
+ * Each thread sorts its part of the array. Blocks of 64 ints are
+ * loaded into 8 AVX2 registers and sorted by a sorting network applied
+ * to all 8 columns at once, followed by a transpose, which gives 8
+ * sorted runs of 8. Runs are then merged 8 elements at a time:
+ * a bitonic merge network merges 2 sorted registers into a low and a
+ * high register; the low one is stored, and the high one is merged
+ * with the next 8 elements of the input whose next element is smaller.
+ * The choice of input is a conditional move, not a branch.
+ * The sorted parts of the threads are then merged in pairs, in
+ * ceil(log2(nt)) rounds. In each round every thread produces the same
+ * number of output elements, finding where its output starts in the
+ * 2 input runs by binary search along the merge path (co-rank).
+ * If AVX2 isn't supported, runs of 8 are sorted by insertion sort and
+ * merged by a branchless scalar merge.
+ * Compares times with qsort, an introsort with inlined comparisons
+ * (like C++ std::sort), and parMergeSort from mergeSortOMPSPMD.c, and
+ * checks results against qsort.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <omp.h>
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+#define BLOCK 64 //ints sorted in registers
+#define RUN 8 //length of sorted runs in a block
+#define INSERTION 16 //introsort uses insertion sort below this size
+
+//sorts each run of RUN ints in a[0..n), where n is a multiple of BLOCK
+typedef void (*SortRuns)(int *a, long n);
+//merges A[0..na) and B[0..nb) into C
+typedef void (*MergeKernel)(const int *A, long na, const int *B, long nb,
+		int *C);
+
+//chooses kernels for this processor, name of instruction set in name
+void selectKernels(SortRuns *sortRuns, MergeKernel *merge, const char **name);
+//parallel SIMD merge sort of a[0..n) using b as work array,
+//returns pointer to sorted array (a or b)
+int *simdMergeSort(int *a, int *b, long n, SortRuns sortRuns,
+		MergeKernel merge);
+//sort a[0..n) with runs of RUN already sorted, using b as work array,
+//result in a
+void bottomUp(int *a, int *b, long n, MergeKernel merge);
+//returns index i in A such that the first k elements of the merge of
+//A[0..na) and B[0..nb) are A[0..i) and B[0..k-i)
+long coRank(long k, const int *A, long na, const int *B, long nb);
+//scalar kernels
+void sortRunsScalar(int *a, long n);
+void mergeScalar(const int *A, long na, const int *B, long nb, int *C);
+//sort a[0..n) by introsort
+void introSort(int *a, long n);
+//comparison function for sequential sort
+int comparefunc(const void * arg1, const void * arg2);
+//parallel merge sort from mergeSortOMPSPMD.c
+int *parMergeSort(int *a, int *b, int n);
+void spmdMerge(int *a, int low1, int low2, int up2, int *b, int nmt, int idm);
+void sequentialMerge(int *a, int low1, int up1, int low2, int up2, int *b, int start);
+void mergeSort(int *a, int lower, int upper, int *b);
+void merge(int *a, int lower, int mid, int upper, int *b);
+void swap(int **a, int **b);
+//time in seconds since t
+double elapsed(struct timespec t);
+
+int main(int argc, char **argv){
+	int *a; //array to be sorted
+	int *b; //array used for merging
+	int *c; //copy of unsorted array
+	int *bs; //array used for sequential sort
+	long n; //size of arrays
+
+	struct timespec tstart;
+	float timer;
+
+	if(argc < 2){
+		fprintf(stderr,"usage: %s n\n", argv[0]);
+		return 1;
+	}
+	n = strtol(argv[1], NULL, 10);
+	if(n < 1 || n > 0x7fffffff){
+		fprintf(stderr,"n must be between 1 and 2^31-1\n");
+		return 1;
+	}
+	int nt = omp_get_max_threads();
+	a = malloc(n*sizeof(int));
+	b = malloc(n*sizeof(int));
+	c = malloc(n*sizeof(int));
+	bs = malloc(n*sizeof(int));
+	if(a == NULL || b == NULL || c == NULL || bs == NULL){
+		fprintf(stderr,"couldn't allocate array of %ld ints\n", n);
+		return 1;
+	}
+	srand(time(NULL));
+	for(long i=0; i<n; i++)
+		c[i] = rand();
+
+	SortRuns sortRuns;
+	MergeKernel mergeKernel;
+	const char *name;
+	selectKernels(&sortRuns, &mergeKernel, &name);
+	printf("n = %ld, %d threads, %s kernels\n", n, nt, name);
+	printf("%-28s %12s %12s %8s\n", "sort", "time (s)", "Mkeys/s", "speedup");
+
+	memcpy(bs, c, n*sizeof(int));
+	clock_gettime(CLOCK_MONOTONIC, &tstart);
+	qsort(bs, n, sizeof(int), comparefunc);
+	float qsortTime = elapsed(tstart);
+	printf("%-28s %12f %12.1f %8.2f\n", "qsort", qsortTime, n/qsortTime*1e-6,
+			1.0);
+
+	for(int s=0; s<4; s++){
+		const char *label;
+		int *result = a;
+		memcpy(a, c, n*sizeof(int));
+		clock_gettime(CLOCK_MONOTONIC, &tstart);
+		switch(s){
+			case 0:
+				label = "introsort";
+				introSort(a, n);
+				break;
+			case 1:
+				label = "parMergeSort";
+				memcpy(b, a, n*sizeof(int));
+				result = parMergeSort(a, b, n);
+				break;
+			case 2:
+				label = "SIMD merge sort, 1 thread";
+				omp_set_num_threads(1);
+				result = simdMergeSort(a, b, n, sortRuns, mergeKernel);
+				omp_set_num_threads(nt);
+				break;
+			default:
+				label = "SIMD merge sort";
+				result = simdMergeSort(a, b, n, sortRuns, mergeKernel);
+		}
+		timer = elapsed(tstart);
+		printf("%-28s %12f %12.1f %8.2f\n", label, timer, n/timer*1e-6,
+				qsortTime/timer);
+		if(memcmp(result, bs, n*sizeof(int)))
+			printf("%s result differs from qsort\n", label);
+	}
+	return 0;
+}
+
+double elapsed(struct timespec t){
+	struct timespec tend;
+	clock_gettime(CLOCK_MONOTONIC, &tend);
+	return (tend.tv_sec-t.tv_sec) + (tend.tv_nsec-t.tv_nsec)*1.0e-9;
+}
+
+int *simdMergeSort(int *a, int *b, long n, SortRuns sortRuns,
+		MergeKernel merge){
+	int nt = omp_get_max_threads();
+	if(nt > n)
+		nt = n;
+	#pragma omp parallel num_threads(nt) firstprivate(a, b)
+	{
+		int id = omp_get_thread_num();
+		long lower = id*n/nt;
+		long upper = (id+1)*n/nt;
+		//each thread sorts its part into a
+		long m = upper - lower;
+		long mb = m/BLOCK*BLOCK;
+		sortRuns(a+lower, mb);
+		sortRunsScalar(a+lower+mb, m-mb);
+		bottomUp(a+lower, b+lower, m, merge);
+		//merge runs of w parts with neighbouring runs
+		for(int w=1; w<nt; w*=2){
+			#pragma omp barrier
+			//my output [out0..out1) of whole array
+			long out0 = lower, out1 = upper;
+			for(int g=0; g<nt; g+=2*w){
+				long s0 = g*n/nt; //start of first run
+				long s1 = (g+w < nt ? g+w : nt)*n/nt; //start of second
+				long s2 = (g+2*w < nt ? g+2*w : nt)*n/nt; //end of second
+				long k0 = out0 > s0 ? out0 : s0;
+				long k1 = out1 < s2 ? out1 : s2;
+				if(k0 >= k1)
+					continue;
+				long i0 = coRank(k0-s0, a+s0, s1-s0, a+s1, s2-s1);
+				long i1 = coRank(k1-s0, a+s0, s1-s0, a+s1, s2-s1);
+				merge(a+s0+i0, i1-i0, a+s1+(k0-s0-i0), (k1-k0)-(i1-i0), b+k0);
+			}
+			int *temp = a;
+			a = b;
+			b = temp;
+		}
+	}
+	//number of merge rounds determines where result is
+	int rounds = 0;
+	for(int w=1; w<nt; w*=2)
+		rounds++;
+	return rounds%2 ? b : a;
+}
+
+void bottomUp(int *a, int *b, long n, MergeKernel merge){
+	int *from = a, *to = b;
+	for(long w=RUN; w<n; w*=2){
+		for(long lo=0; lo<n; lo+=2*w){
+			long mid = lo+w < n ? lo+w : n;
+			long hi = lo+2*w < n ? lo+2*w : n;
+			merge(from+lo, mid-lo, from+mid, hi-mid, to+lo);
+		}
+		int *temp = from;
+		from = to;
+		to = temp;
+	}
+	if(from != a)
+		memcpy(a, from, n*sizeof(int));
+}
+
+long coRank(long k, const int *A, long na, const int *B, long nb){
+	long lo = k > nb ? k-nb : 0;
+	long hi = k < na ? k : na;
+	//find smallest i such that taking i from A and k-i from B is
+	//consistent with merge taking A first on ties
+	while(lo < hi){
+		long i = (lo+hi)/2;
+		long j = k-i;
+		if(j > 0 && i < na && B[j-1] >= A[i])
+			lo = i+1;
+		else
+			hi = i;
+	}
+	return lo;
+}
+
+void sortRunsScalar(int *a, long n){
+	for(long lo=0; lo<n; lo+=RUN){
+		long hi = lo+RUN < n ? lo+RUN : n;
+		for(long i=lo+1; i<hi; i++){
+			int x = a[i];
+			long j = i;
+			for(; j>lo && a[j-1] > x; j--)
+				a[j] = a[j-1];
+			a[j] = x;
+		}
+	}
+}
+
+void mergeScalar(const int *A, long na, const int *B, long nb, int *C){
+	long i = 0, j = 0, k = 0;
+	while(i < na && j < nb){
+		int x = A[i], y = B[j];
+		int takeA = x <= y;
+		C[k++] = takeA ? x : y;
+		i += takeA;
+		j += !takeA;
+	}
+	memcpy(C+k, A+i, (na-i)*sizeof(int));
+	memcpy(C+k+na-i, B+j, (nb-j)*sizeof(int));
+}
+
+#ifdef __x86_64__
+//compare-exchange of registers
+#define COEX(x, y) {__m256i t = _mm256_min_epi32(x, y); \
+		y = _mm256_max_epi32(x, y); x = t;}
+
+__attribute__((target("avx2")))
+void sortRunsAVX2(int *a, long n){
+	for(long lo=0; lo<n; lo+=BLOCK){
+		__m256i r0, r1, r2, r3, r4, r5, r6, r7;
+		__m256i *p = (__m256i *)(a+lo);
+		r0 = _mm256_loadu_si256(p); r1 = _mm256_loadu_si256(p+1);
+		r2 = _mm256_loadu_si256(p+2); r3 = _mm256_loadu_si256(p+3);
+		r4 = _mm256_loadu_si256(p+4); r5 = _mm256_loadu_si256(p+5);
+		r6 = _mm256_loadu_si256(p+6); r7 = _mm256_loadu_si256(p+7);
+		//sorting network for 8 inputs, sorts each column
+		COEX(r0, r2); COEX(r1, r3); COEX(r4, r6); COEX(r5, r7);
+		COEX(r0, r4); COEX(r1, r5); COEX(r2, r6); COEX(r3, r7);
+		COEX(r0, r1); COEX(r2, r3); COEX(r4, r5); COEX(r6, r7);
+		COEX(r2, r4); COEX(r3, r5);
+		COEX(r1, r4); COEX(r3, r6);
+		COEX(r1, r2); COEX(r3, r4); COEX(r5, r6);
+		//transpose, so each register holds a sorted column
+		__m256i t0 = _mm256_unpacklo_epi32(r0, r1);
+		__m256i t1 = _mm256_unpackhi_epi32(r0, r1);
+		__m256i t2 = _mm256_unpacklo_epi32(r2, r3);
+		__m256i t3 = _mm256_unpackhi_epi32(r2, r3);
+		__m256i t4 = _mm256_unpacklo_epi32(r4, r5);
+		__m256i t5 = _mm256_unpackhi_epi32(r4, r5);
+		__m256i t6 = _mm256_unpacklo_epi32(r6, r7);
+		__m256i t7 = _mm256_unpackhi_epi32(r6, r7);
+		__m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+		__m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+		__m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+		__m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+		__m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+		__m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+		__m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+		__m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+		_mm256_storeu_si256(p, _mm256_permute2x128_si256(u0, u4, 0x20));
+		_mm256_storeu_si256(p+1, _mm256_permute2x128_si256(u1, u5, 0x20));
+		_mm256_storeu_si256(p+2, _mm256_permute2x128_si256(u2, u6, 0x20));
+		_mm256_storeu_si256(p+3, _mm256_permute2x128_si256(u3, u7, 0x20));
+		_mm256_storeu_si256(p+4, _mm256_permute2x128_si256(u0, u4, 0x31));
+		_mm256_storeu_si256(p+5, _mm256_permute2x128_si256(u1, u5, 0x31));
+		_mm256_storeu_si256(p+6, _mm256_permute2x128_si256(u2, u6, 0x31));
+		_mm256_storeu_si256(p+7, _mm256_permute2x128_si256(u3, u7, 0x31));
+	}
+	_mm256_zeroupper();
+}
+
+//merges sorted registers x and y, smallest 8 in x and largest in y
+__attribute__((target("avx2")))
+static inline void bitonicMerge(__m256i *x, __m256i *y){
+	const __m256i rev = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+	__m256i yr = _mm256_permutevar8x32_epi32(*y, rev);
+	__m256i lo = _mm256_min_epi32(*x, yr);
+	__m256i hi = _mm256_max_epi32(*x, yr);
+	//lo and hi are bitonic, sort with half cleaners of size 8, 4, 2
+	#define HALF_CLEAN(v, perm, mask) {__m256i t = perm; \
+			v = _mm256_blend_epi32(_mm256_min_epi32(v, t), \
+			_mm256_max_epi32(v, t), mask);}
+	HALF_CLEAN(lo, _mm256_permute2x128_si256(lo, lo, 1), 0xF0)
+	HALF_CLEAN(hi, _mm256_permute2x128_si256(hi, hi, 1), 0xF0)
+	HALF_CLEAN(lo, _mm256_shuffle_epi32(lo, _MM_SHUFFLE(1, 0, 3, 2)), 0xCC)
+	HALF_CLEAN(hi, _mm256_shuffle_epi32(hi, _MM_SHUFFLE(1, 0, 3, 2)), 0xCC)
+	HALF_CLEAN(lo, _mm256_shuffle_epi32(lo, _MM_SHUFFLE(2, 3, 0, 1)), 0xAA)
+	HALF_CLEAN(hi, _mm256_shuffle_epi32(hi, _MM_SHUFFLE(2, 3, 0, 1)), 0xAA)
+	#undef HALF_CLEAN
+	*x = lo;
+	*y = hi;
+}
+
+__attribute__((target("avx2")))
+void mergeAVX2(const int *A, long na, const int *B, long nb, int *C){
+	if(na < RUN || nb < RUN){
+		mergeScalar(A, na, B, nb, C);
+		return;
+	}
+	__m256i lo = _mm256_loadu_si256((const __m256i *)A);
+	__m256i hi = _mm256_loadu_si256((const __m256i *)B);
+	long i = RUN, j = RUN, k = 0;
+	bitonicMerge(&lo, &hi);
+	_mm256_storeu_si256((__m256i *)C, lo);
+	k += RUN;
+	while(i+RUN <= na && j+RUN <= nb){
+		//next 8 from input with smaller next element
+		int takeA = A[i] <= B[j];
+		const int *next = takeA ? A+i : B+j;
+		i += takeA ? RUN : 0;
+		j += takeA ? 0 : RUN;
+		lo = _mm256_loadu_si256((const __m256i *)next);
+		bitonicMerge(&lo, &hi);
+		_mm256_storeu_si256((__m256i *)(C+k), lo);
+		k += RUN;
+	}
+	//merge rest of A and B (one has less than 8 left) with hi
+	int h[RUN];
+	_mm256_storeu_si256((__m256i *)h, hi);
+	_mm256_zeroupper();
+	long ih = 0;
+	while(ih < RUN && (i < na || j < nb)){
+		int x = h[ih];
+		if(i < na && A[i] <= x && (j >= nb || A[i] <= B[j]))
+			C[k++] = A[i++];
+		else if(j < nb && B[j] < x)
+			C[k++] = B[j++];
+		else
+			C[k++] = h[ih++];
+	}
+	memcpy(C+k, h+ih, (RUN-ih)*sizeof(int));
+	k += RUN-ih;
+	mergeScalar(A+i, na-i, B+j, nb-j, C+k);
+}
+#endif
+
+void selectKernels(SortRuns *sortRuns, MergeKernel *merge, const char **name){
+	#ifdef __x86_64__
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2")){
+		*name = "avx2";
+		*sortRuns = sortRunsAVX2;
+		*merge = mergeAVX2;
+		return;
+	}
+	#endif
+	*name = "scalar";
+	*sortRuns = sortRunsScalar;
+	*merge = mergeScalar;
+}
+
+//introsort, with heapsort when recursion is too deep
+void heapSort(int *a, long n){
+	for(long s=n/2-1; s>=-n+1; s--){
+		//build heap, then move max to end
+		long root = s, end = n;
+		if(s < 0){
+			end = n+s;
+			int t = a[0]; a[0] = a[end]; a[end] = t;
+			root = 0;
+		}
+		int x = a[root];
+		for(long child; (child = 2*root+1) < end; root = child){
+			if(child+1 < end && a[child+1] > a[child])
+				child++;
+			if(a[child] <= x)
+				break;
+			a[root] = a[child];
+		}
+		a[root] = x;
+	}
+}
+
+void introSortLoop(int *a, long n, int depth){
+	while(n > INSERTION){
+		if(depth-- == 0){
+			heapSort(a, n);
+			return;
+		}
+		//median of 3 pivot
+		long mid = n/2;
+		int x = a[0], y = a[mid], z = a[n-1];
+		int pivot = x < y ? (y < z ? y : (x < z ? z : x))
+				: (x < z ? x : (y < z ? z : y));
+		long i = 0, j = n-1;
+		while(i <= j){
+			while(a[i] < pivot)
+				i++;
+			while(a[j] > pivot)
+				j--;
+			if(i <= j){
+				int t = a[i]; a[i] = a[j]; a[j] = t;
+				i++;
+				j--;
+			}
+		}
+		//recurse on smaller part
+		if(j+1 < n-i){
+			introSortLoop(a, j+1, depth);
+			a += i;
+			n -= i;
+		} else{
+			introSortLoop(a+i, n-i, depth);
+			n = j+1;
+		}
+	}
+	for(long i=1; i<n; i++){
+		int x = a[i];
+		long j = i;
+		for(; j>0 && a[j-1] > x; j--)
+			a[j] = a[j-1];
+		a[j] = x;
+	}
+}
+
+void introSort(int *a, long n){
+	int depth = 0;
+	for(long m=n; m>1; m>>=1)
+		depth += 2;
+	introSortLoop(a, n, depth);
+}
+
+int comparefunc(const void * arg1, const void * arg2){
+  const int x = * (const int *)arg1;
+  const int y = * (const int *)arg2;
+	return x - y;
+}
+
+int *parMergeSort(int *a, int *b, int n){
+	int nt = omp_get_max_threads();
+	int lognt = 0; //ceil(log2(nt))
+	while((1 << lognt) < nt)
+		lognt++;
+	#pragma omp parallel firstprivate(a, b)
+	{
+		int id = omp_get_thread_num();
+		int lower = (long)id*n/nt;
+		int upper = (long)(id+1)*n/nt;
+		//each thread sorts its chunk
+		mergeSort(a, lower, upper, b);
+		#pragma omp barrier
+		int nmt = 1;
+		for(int i=1; i<=lognt; i++){
+			swap(&a, &b);
+			int half = nmt;
+			nmt *= 2;
+			//group of threads idc..idc+nmt-1 (fewer in last group)
+			int idc = (id/nmt)*nmt;
+			int mid = idc+half < nt ? idc+half : nt;
+			int end = idc+nmt < nt ? idc+nmt : nt;
+			int low1 = (long)idc*n/nt;
+			int low2 = (long)mid*n/nt;
+			int up2 = (long)end*n/nt;
+			spmdMerge(a, low1, low2, up2, b, end-idc, id-idc);
+			#pragma omp barrier
+		}
+	}
+	if(lognt%2)
+		return a;
+	else
+		return b;
+}
+
+void spmdMerge(int *a, int low1, int low2, int up2, int *b, int nmt, int idm){
+	int len = up2-low1;
+	int k1 = (long)idm*len/nmt;
+	int k2 = (long)(idm+1)*len/nmt;
+	int lowX = low1 + coRank(k1, a+low1, low2-low1, a+low2, up2-low2);
+	int upX = low1 + coRank(k2, a+low1, low2-low1, a+low2, up2-low2);
+	int lowY = low2 + k1 - (lowX-low1);
+	int upY = low2 + k2 - (upX-low1);
+	sequentialMerge(a, lowX, upX, lowY, upY, b, low1+k1);
+}
+
+void sequentialMerge(int *a, int low1, int up1, int low2, int up2, int *b, int start){
+	int i = low1, j = low2;
+	int nel = up1-low1+up2-low2;
+	for(int k=start; k<start+nel; k++){
+		if((i < up1) && ((j >= up2) || (a[i] <= a[j])))
+			b[k] = a[i++];
+		else
+			b[k] = a[j++];
+	}
+}
+
+void swap(int **a, int **b){
+	int *temp = *a;
+	*a = *b;
+	*b = temp;
+}
+
+void mergeSort(int *a, int lower, int upper, int *b){
+	if(upper - lower < 2)
+		return;
+	int mid = (upper + lower)/2;
+	mergeSort(b, lower, mid, a);
+	mergeSort(b, mid, upper, a);
+	merge(a, lower, mid, upper, b);
+}
+
+void merge(int *a, int lower, int mid, int upper, int *b){
+	int i = lower, j = mid;
+	for(int k=lower; k<upper; k++)
+		if((i < mid) && ((j >= upper) || (a[i] <= a[j])))
+			b[k] = a[i++];
+		else
+			b[k] = a[j++];
+}
@@ -0,0 +1,119 @@
+// Implementation of Philox4x32-10 random number generator (see philox.h).
+#include <string.h>
+#include "philox.h"
+
+#define ROUNDS 10
+#define M0 0xD2511F53u //round multipliers
+#define M1 0xCD9E8D57u
+#define W0 0x9E3779B9u //key increments
+#define W1 0xBB67AE85u
+#define CHUNK (16*PHILOX_WIDTH) //words converted at a time by philoxUniform
+
+// words of PHILOX_WIDTH counters ctr, ctr+1, ... of stream into out
+static inline __attribute__((always_inline))
+void block(uint64_t ctr, uint64_t stream, uint32_t k0, uint32_t k1,
+		uint32_t *out){
+	//counters stored by word, so rounds are applied to vectors of words
+	uint32_t x0[PHILOX_WIDTH], x1[PHILOX_WIDTH];
+	uint32_t x2[PHILOX_WIDTH], x3[PHILOX_WIDTH];
+	for(int j=0; j<PHILOX_WIDTH; j++){
+		x0[j] = (uint32_t)(ctr+j);
+		x1[j] = (ctr+j) >> 32;
+		x2[j] = (uint32_t)stream;
+		x3[j] = stream >> 32;
+	}
+	for(int r=0; r<ROUNDS; r++){
+		for(int j=0; j<PHILOX_WIDTH; j++){
+			uint64_t p0 = (uint64_t)M0*x0[j];
+			uint64_t p1 = (uint64_t)M1*x2[j];
+			uint32_t y0 = (uint32_t)(p1 >> 32) ^ x1[j] ^ k0;
+			uint32_t y2 = (uint32_t)(p0 >> 32) ^ x3[j] ^ k1;
+			x1[j] = (uint32_t)p1;
+			x3[j] = (uint32_t)p0;
+			x0[j] = y0;
+			x2[j] = y2;
+		}
+		k0 += W0;
+		k1 += W1;
+	}
+	for(int j=0; j<PHILOX_WIDTH; j++){
+		out[4*j] = x0[j];
+		out[4*j+1] = x1[j];
+		out[4*j+2] = x2[j];
+		out[4*j+3] = x3[j];
+	}
+}
+
+static void blockScalar(uint64_t ctr, uint64_t stream, uint32_t k0,
+		uint32_t k1, uint32_t *out){
+	block(ctr, stream, k0, k1, out);
+}
+
+#ifdef __x86_64__
+__attribute__((target("avx2")))
+static void blockAVX2(uint64_t ctr, uint64_t stream, uint32_t k0,
+		uint32_t k1, uint32_t *out){
+	block(ctr, stream, k0, k1, out);
+}
+#endif
+
+void philox4x32(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4]){
+	uint32_t x0 = ctr[0], x1 = ctr[1], x2 = ctr[2], x3 = ctr[3];
+	uint32_t k0 = key[0], k1 = key[1];
+	for(int r=0; r<ROUNDS; r++){
+		uint64_t p0 = (uint64_t)M0*x0;
+		uint64_t p1 = (uint64_t)M1*x2;
+		x0 = (uint32_t)(p1 >> 32) ^ x1 ^ k0;
+		x1 = (uint32_t)p1;
+		x2 = (uint32_t)(p0 >> 32) ^ x3 ^ k1;
+		x3 = (uint32_t)p0;
+		k0 += W0;
+		k1 += W1;
+	}
+	out[0] = x0;
+	out[1] = x1;
+	out[2] = x2;
+	out[3] = x3;
+}
+
+void philoxFill(uint64_t seed, uint64_t stream, uint64_t pos, uint32_t *out,
+		long n){
+	void (*gen)(uint64_t, uint64_t, uint32_t, uint32_t, uint32_t *) =
+		blockScalar;
+#ifdef __x86_64__
+	if(__builtin_cpu_supports("avx2"))
+		gen = blockAVX2;
+#endif
+	uint32_t k0 = (uint32_t)seed, k1 = seed >> 32;
+	uint64_t ctr = pos/4;
+	uint32_t buf[4*PHILOX_WIDTH];
+	long i = 0;
+	//words before first whole counter
+	int skip = pos%4;
+	if(skip && n > 0){
+		uint32_t c[4] = {(uint32_t)ctr, ctr >> 32, (uint32_t)stream,
+			stream >> 32};
+		uint32_t key[2] = {k0, k1};
+		philox4x32(c, key, buf);
+		for(; i<n && skip+i<4; i++)
+			out[i] = buf[skip+i];
+		ctr++;
+	}
+	for(; n-i >= 4*PHILOX_WIDTH; i+=4*PHILOX_WIDTH, ctr+=PHILOX_WIDTH)
+		gen(ctr, stream, k0, k1, out+i);
+	if(i < n){
+		gen(ctr, stream, k0, k1, buf);
+		memcpy(out+i, buf, (n-i)*sizeof(uint32_t));
+	}
+}
+
+void philoxUniform(uint64_t seed, uint64_t stream, uint64_t pos, float *out,
+		long n){
+	uint32_t buf[CHUNK];
+	for(long i=0; i<n; i+=CHUNK){
+		long m = n-i < CHUNK ? n-i : CHUNK;
+		philoxFill(seed, stream, pos+i, buf, m);
+		for(long j=0; j<m; j++)
+			out[i+j] = (buf[j] >> 8)*0x1p-24f;
+	}
+}
@@ -0,0 +1,26 @@
+// Philox4x32-10 counter-based random number generator of Salmon, Moraes,
+// Dror and Shaw, "Parallel Random Numbers: As Easy as 1, 2, 3", SC 2011,
+// used by piOMP.c, piOMPReduction.c and piForkJoin.c.
+// Random numbers aren't produced by updating a state, but by applying 10
+// rounds of a bijection to a 128-bit counter, with a 64-bit key. So any
+// part of a sequence can be generated directly, and each thread or task
+// gets its own independent stream from (seed, stream id), with no seeds
+// to share or collide. Word pos of stream s with seed k is word pos%4
+// of the output for counter {pos/4, s} and key k. The same numbers are
+// produced however the work is divided among threads.
+// The batch functions generate PHILOX_WIDTH counters at a time, in loops
+// that are vectorized with AVX2 if supported (compile with -O3).
+#ifndef PHILOX_H
+#define PHILOX_H
+#include <stdint.h>
+#define PHILOX_WIDTH 16 //counters generated together by batch functions
+
+// out = Philox4x32-10 of counter ctr with key
+void philox4x32(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4]);
+// n 32-bit words of stream starting at word pos
+void philoxFill(uint64_t seed, uint64_t stream, uint64_t pos, uint32_t *out,
+		long n);
+// n floats uniform in [0,1) (24 random bits) from words starting at pos
+void philoxUniform(uint64_t seed, uint64_t stream, uint64_t pos, float *out,
+		long n);
+#endif
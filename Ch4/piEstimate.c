@@ -17,24 +17,35 @@
  *
  * -------------------------------------------------------------------
  * Implementation of recursive estimation of pi
+ * If cutoff isn't given it is found by calibration trials, or from a
+ * previous calibration saved in a profile file (see cutoffTuner.h)
  */
  #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
+#include "cutoffTuner.h"
 
 float recPi(int n);
+//time of recPi(n) with cutoff c, used by tuneCutoff
+double trialPi(long n, int c);
 int cutoff; //cutoff for recursion
+int printSeed = 1; //piEst prints its seed
 
 int main(int argc, char **argv){
 	struct timespec tstart,tend; 
   float timer;
 
-	if(argc < 3){
-		fprintf(stderr,"usage: %s n cutoff\n", argv[0]);
+	if(argc < 2){
+		fprintf(stderr,"usage: %s n [cutoff]\n", argv[0]);
 		return 1;
 	}
 	int n = strtol(argv[1], NULL, 10);
-	cutoff = strtol(argv[2], NULL, 10);
+	cutoff = argc > 2 ? strtol(argv[2], NULL, 10) : 0;
+	if(cutoff <= 0){
+		printSeed = 0;
+		cutoff = tuneCutoff("piEstimate", n, 1, trialPi);
+		printSeed = 1;
+	}
 
 	clock_gettime(CLOCK_MONOTONIC, &tstart);
 	float piEst = recPi(n)*4/n;
@@ -52,7 +63,8 @@ float piEst(int n){
 	struct timespec t;
 	clock_gettime(CLOCK_MONOTONIC, &t);
 	unsigned int seed = t.tv_nsec;
-	printf("seed=%u\n", seed);
+	if(printSeed)
+		printf("seed=%u\n", seed);
 	for(int i=0; i<n; i++){
 		float x = (float)rand_r(&seed)/RAND_MAX*2-1;
 		float y = (float)rand_r(&seed)/RAND_MAX*2-1;
@@ -74,3 +86,11 @@ float recPi(int n){
 	return sum;
 }
 
+double trialPi(long n, int c){
+	struct timespec tstart,tend;
+	cutoff = c;
+	clock_gettime(CLOCK_MONOTONIC, &tstart);
+	recPi(n);
+	clock_gettime(CLOCK_MONOTONIC, &tend);
+	return (tend.tv_sec-tstart.tv_sec) + (tend.tv_nsec-tstart.tv_nsec)*1.0e-9;
+}
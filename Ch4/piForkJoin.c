@@ -16,64 +16,123 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  *
  * -------------------------------------------------------------------
- * Implementation of fork-join estimation of pi using Cilk Plus
+ * Implementation of fork-join estimation of pi using the work-stealing
+ * runtime of workSteal.h (in place of Cilk Plus). Number of workers is
+ * given by environment variable WS_NUM_WORKERS (default number of cores).
+ * If cutoff isn't given it is found by calibration trials, or from a
+ * previous calibration saved in a profile file (see cutoffTuner.h)
+ * Random numbers come from the counter-based generator of philox.h:
+ * samples are divided into blocks of BLOCK, each with its own stream,
+ * so the estimate for a given seed is the same for any number of
+ * workers and any cutoff.
  */
  #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
-#include <cilk/cilk.h>
-#include <cilk/cilk_api.h>
+#include <stdint.h>
+#include "workSteal.h"
+#include "cutoffTuner.h"
+#include "philox.h"
 
-float recPi(int n);
+#define BLOCK 1024 //samples per random stream
+
+//number of samples in unit circle of random samples lo .. lo+n-1
+long recPi(long lo, long n);
+//arguments and result of recPi as task
+typedef struct{
+	long lo, n;
+	long sum;
+} PiArgs;
+void recPiTask(void *arg);
+//time of recPi(0, n) with cutoff c, used by tuneCutoff
+double trialPi(long n, int c);
+//number of samples in [lo, hi) inside unit circle
+long countHits(long lo, long hi);
 int cutoff; //cutoff for recursion
+uint64_t seed; //of random numbers
 
 int main(int argc, char **argv){
 	struct timespec tstart,tend; 
   float timer;
 
-	if(argc < 3){
-		fprintf(stderr,"usage: %s n cutoff\n", argv[0]);
+	if(argc < 2){
+		fprintf(stderr,"usage: %s n [cutoff [seed]]\n", argv[0]);
 		return 1;
 	}
-	int n = strtol(argv[1], NULL, 10);
-	cutoff = strtol(argv[2], NULL, 10);
+	long n = strtol(argv[1], NULL, 10);
+	cutoff = argc > 2 ? strtol(argv[2], NULL, 10) : 0;
+	seed = argc > 3 ? strtoull(argv[3], NULL, 10) : 1;
+	wsInit(0);
+	if(cutoff <= 0){
+		cutoff = tuneCutoff("piForkJoin", n, wsNumWorkers(), trialPi);
+		wsResetStats();
+	}
+	printf("seed=%llu\n", (unsigned long long)seed);
 
+	PiArgs args = {0, n, 0};
 	clock_gettime(CLOCK_MONOTONIC, &tstart);
-	float piEst = recPi(n)*4/n;
+	wsRun(recPiTask, &args);
+	double piEst = (double)args.sum*4/n;
 	clock_gettime(CLOCK_MONOTONIC, &tend);
   timer = (tend.tv_sec-tstart.tv_sec) +
         (tend.tv_nsec-tstart.tv_nsec)*1.0e-9;
 
-	printf("pi is approx %f\n", piEst);
-	printf("time in s, using %d workers: %f\n", timer, __cilkrts_get_nworkers());
+	printf("pi is approx %.9f\n", piEst);
+	printf("time in s, using %d workers: %f\n", wsNumWorkers(), timer);
+	printf("samples/s: %g\n", n/timer);
+	wsPrintStats(stdout);
+	wsFinalize();
 	return 0;
 }
 
-float piEst(int n){
-	float sum=0.0;
-	struct timespec t;
-	clock_gettime(CLOCK_MONOTONIC, &t);
-	unsigned int seed = t.tv_nsec;
-	printf("seed=%u\n", seed);
-	for(int i=0; i<n; i++){
-		float x = (float)rand_r(&seed)/RAND_MAX*2-1;
-		float y = (float)rand_r(&seed)/RAND_MAX*2-1;
-		if(x*x + y*y <= 1.0)
-			sum++;
+long recPi(long lo, long n){
+	long sum;
+	if(n < cutoff || n < 2)
+		sum = countHits(lo, lo+n);
+	else{
+		PiArgs args = {lo, n/2, 0};
+		WsGroup g = WS_GROUP_INIT;
+		WsTask t;
+		wsSpawn(&g, &t, recPiTask, &args);
+		long sum2 = recPi(lo+n/2, n-n/2);
+		wsSync(&g);
+		sum = args.sum + sum2;
 	}
 	return sum;
 }
 
-float recPi(int n){
-	float sum;
-	if(n < cutoff)
-		sum = piEst(n);
-	else{
-		float sum1 = cilk_spawn recPi(n/2);
-		float sum2 = recPi(n/2);
-		cilk_sync; 
-		sum = sum1 + sum2;
+void recPiTask(void *arg){
+	PiArgs *args = arg;
+	args->sum = recPi(args->lo, args->n);
+}
+
+long countHits(long lo, long hi){
+	float u[2*BLOCK];
+	long hits = 0;
+	//sample i is (x,y) from words 2(i%BLOCK) and 2(i%BLOCK)+1 of stream i/BLOCK
+	while(lo < hi){
+		long b = lo/BLOCK;
+		long first = lo - b*BLOCK;
+		long last = hi - b*BLOCK < BLOCK ? hi - b*BLOCK : BLOCK;
+		long m = 2*(last-first);
+		philoxUniform(seed, b, 2*first, u, m);
+		for(long i=0; i<m; i+=2){
+			float x = u[i]*2-1;
+			float y = u[i+1]*2-1;
+			if(x*x + y*y <= 1.0f)
+				hits++;
+		}
+		lo = b*BLOCK + last;
 	}
-	return sum;
+	return hits;
 }
 
+double trialPi(long n, int c){
+	struct timespec tstart,tend;
+	PiArgs args = {0, n, 0};
+	cutoff = c;
+	clock_gettime(CLOCK_MONOTONIC, &tstart);
+	wsRun(recPiTask, &args);
+	clock_gettime(CLOCK_MONOTONIC, &tend);
+	return (tend.tv_sec-tstart.tv_sec) + (tend.tv_nsec-tstart.tv_nsec)*1.0e-9;
+}
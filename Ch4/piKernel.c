@@ -0,0 +1,380 @@
+// Implementation of vectorized Monte Carlo pi kernels (see piKernel.h).
+// Coordinates are computed as ((int32_t)(w ^ 2^31) >> 8)*2^-23 (float)
+// and (int32_t)(w ^ 2^31)*2^-31 (double) from word w, which for float is
+// exactly u*2-1 with u = (w>>8)*2^-24 as in the pi programs, and needs
+// only a signed integer conversion.
+#include "philox.h"
+#include "piKernel.h"
+//x*x + y*y mustn't be contracted into a fused multiply-add (which
+//AVX-512 has), so hits are the same for all instruction sets
+#pragma GCC optimize("fp-contract=off")
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+#define ROUNDS 10 //Philox constants, as in philox.c
+#define M0 0xD2511F53u
+#define M1 0xCD9E8D57u
+#define W0 0x9E3779B9u
+#define W1 0xBB67AE85u
+#define SIGN 0x80000000u
+
+// hits of samples 2c0 .. 2c1-1 of stream (counters c0 .. c1-1)
+typedef long (*CounterKernel)(uint64_t seed, uint64_t stream, long c0,
+		long c1);
+// 1 if sample s of stream is inside unit circle
+typedef int (*SampleTest)(uint64_t seed, uint64_t stream, long s);
+
+// hits of samples in [lo, hi), with whole counters counted by kernel k
+// and samples of a counter outside [lo, hi) removed with test t
+static long countHits(CounterKernel k, SampleTest t, uint64_t seed,
+		long lo, long hi);
+// Philox output for counter c of stream
+static void counterWords(uint64_t seed, uint64_t stream, long c,
+		uint32_t w[4]);
+static int insideFloat(uint32_t wx, uint32_t wy);
+static int insideDouble(uint32_t wx, uint32_t wy);
+
+static long countHits(CounterKernel k, SampleTest t, uint64_t seed,
+		long lo, long hi){
+	long hits = 0;
+	while(lo < hi){
+		long b = lo/PI_BLOCK;
+		long first = lo - b*PI_BLOCK;
+		long last = hi - b*PI_BLOCK < PI_BLOCK ? hi - b*PI_BLOCK : PI_BLOCK;
+		hits += k(seed, b, first/2, (last+1)/2);
+		if(first%2)
+			hits -= t(seed, b, first-1);
+		if(last%2)
+			hits -= t(seed, b, last);
+		lo = b*PI_BLOCK + last;
+	}
+	return hits;
+}
+
+static void counterWords(uint64_t seed, uint64_t stream, long c,
+		uint32_t w[4]){
+	uint32_t ctr[4] = {(uint32_t)c, (uint64_t)c >> 32, (uint32_t)stream,
+		stream >> 32};
+	uint32_t key[2] = {(uint32_t)seed, seed >> 32};
+	philox4x32(ctr, key, w);
+}
+
+static int insideFloat(uint32_t wx, uint32_t wy){
+	float x = ((int32_t)(wx ^ SIGN) >> 8)*0x1p-23f;
+	float y = ((int32_t)(wy ^ SIGN) >> 8)*0x1p-23f;
+	return x*x + y*y <= 1.0f;
+}
+
+static int insideDouble(uint32_t wx, uint32_t wy){
+	double x = (int32_t)(wx ^ SIGN)*0x1p-31;
+	double y = (int32_t)(wy ^ SIGN)*0x1p-31;
+	return x*x + y*y <= 1.0;
+}
+
+static int sampleFloat(uint64_t seed, uint64_t stream, long s){
+	uint32_t w[4];
+	counterWords(seed, stream, s/2, w);
+	return insideFloat(w[2*(s%2)], w[2*(s%2)+1]);
+}
+
+static int sampleDouble(uint64_t seed, uint64_t stream, long s){
+	uint32_t w[4];
+	counterWords(seed, stream, s/2, w);
+	return insideDouble(w[2*(s%2)], w[2*(s%2)+1]);
+}
+
+static long countersFloatScalar(uint64_t seed, uint64_t stream, long c0,
+		long c1){
+	long hits = 0;
+	for(long c=c0; c<c1; c++){
+		uint32_t w[4];
+		counterWords(seed, stream, c, w);
+		hits += insideFloat(w[0], w[1]) + insideFloat(w[2], w[3]);
+	}
+	return hits;
+}
+
+static long countersDoubleScalar(uint64_t seed, uint64_t stream, long c0,
+		long c1){
+	long hits = 0;
+	for(long c=c0; c<c1; c++){
+		uint32_t w[4];
+		counterWords(seed, stream, c, w);
+		hits += insideDouble(w[0], w[1]) + insideDouble(w[2], w[3]);
+	}
+	return hits;
+}
+
+#ifdef __x86_64__
+// Philox of counters c .. c+7 of stream, in words x[0..3]
+// (counters within a stream are below 2^32, so c+7 doesn't carry)
+__attribute__((target("avx2")))
+static inline void philoxAVX2(uint64_t seed, uint64_t stream, long c,
+		__m256i x[4]){
+	const __m256i m0 = _mm256_set1_epi32(M0), m1 = _mm256_set1_epi32(M1);
+	x[0] = _mm256_add_epi32(_mm256_set1_epi32((uint32_t)c),
+			_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+	x[1] = _mm256_set1_epi32((uint64_t)c >> 32);
+	x[2] = _mm256_set1_epi32((uint32_t)stream);
+	x[3] = _mm256_set1_epi32(stream >> 32);
+	uint32_t k0 = (uint32_t)seed, k1 = seed >> 32;
+	for(int r=0; r<ROUNDS; r++){
+		//32x32 bit products of even and odd lanes give low and high words
+		__m256i pe0 = _mm256_mul_epu32(x[0], m0);
+		__m256i po0 = _mm256_mul_epu32(_mm256_srli_epi64(x[0], 32), m0);
+		__m256i pe1 = _mm256_mul_epu32(x[2], m1);
+		__m256i po1 = _mm256_mul_epu32(_mm256_srli_epi64(x[2], 32), m1);
+		__m256i lo0 = _mm256_blend_epi32(pe0, _mm256_slli_epi64(po0, 32), 0xAA);
+		__m256i hi0 = _mm256_blend_epi32(_mm256_srli_epi64(pe0, 32), po0, 0xAA);
+		__m256i lo1 = _mm256_blend_epi32(pe1, _mm256_slli_epi64(po1, 32), 0xAA);
+		__m256i hi1 = _mm256_blend_epi32(_mm256_srli_epi64(pe1, 32), po1, 0xAA);
+		x[0] = _mm256_xor_si256(_mm256_xor_si256(hi1, x[1]),
+				_mm256_set1_epi32(k0));
+		x[1] = lo1;
+		x[2] = _mm256_xor_si256(_mm256_xor_si256(hi0, x[3]),
+				_mm256_set1_epi32(k1));
+		x[3] = lo0;
+		k0 += W0;
+		k1 += W1;
+	}
+}
+
+// -1 in lanes of samples inside circle
+__attribute__((target("avx2")))
+static inline __m256i insideFloatAVX2(__m256i wx, __m256i wy){
+	const __m256i sign = _mm256_set1_epi32(SIGN);
+	const __m256 scale = _mm256_set1_ps(0x1p-23f);
+	__m256 x = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srai_epi32(
+					_mm256_xor_si256(wx, sign), 8)), scale);
+	__m256 y = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srai_epi32(
+					_mm256_xor_si256(wy, sign), 8)), scale);
+	__m256 r = _mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y));
+	return _mm256_castps_si256(_mm256_cmp_ps(r, _mm256_set1_ps(1.0f),
+				_CMP_LE_OQ));
+}
+
+// -1 in 64-bit lanes of 4 samples inside circle
+__attribute__((target("avx2")))
+static inline __m256i insideDoubleAVX2(__m128i wx, __m128i wy){
+	const __m128i sign = _mm_set1_epi32(SIGN);
+	const __m256d scale = _mm256_set1_pd(0x1p-31);
+	__m256d x = _mm256_mul_pd(_mm256_cvtepi32_pd(_mm_xor_si128(wx, sign)),
+			scale);
+	__m256d y = _mm256_mul_pd(_mm256_cvtepi32_pd(_mm_xor_si128(wy, sign)),
+			scale);
+	__m256d r = _mm256_add_pd(_mm256_mul_pd(x, x), _mm256_mul_pd(y, y));
+	return _mm256_castpd_si256(_mm256_cmp_pd(r, _mm256_set1_pd(1.0),
+				_CMP_LE_OQ));
+}
+
+__attribute__((target("avx2")))
+static long countersFloatAVX2(uint64_t seed, uint64_t stream, long c0,
+		long c1){
+	__m256i acc = _mm256_setzero_si256(); //hits of each lane
+	long c = c0;
+	for(; c+8 <= c1; c+=8){
+		__m256i x[4];
+		philoxAVX2(seed, stream, c, x);
+		acc = _mm256_sub_epi32(acc, insideFloatAVX2(x[0], x[1]));
+		acc = _mm256_sub_epi32(acc, insideFloatAVX2(x[2], x[3]));
+	}
+	int32_t lanes[8];
+	_mm256_storeu_si256((__m256i *)lanes, acc);
+	long hits = 0;
+	for(int j=0; j<8; j++)
+		hits += lanes[j];
+	return hits + countersFloatScalar(seed, stream, c, c1);
+}
+
+__attribute__((target("avx2")))
+static long countersDoubleAVX2(uint64_t seed, uint64_t stream, long c0,
+		long c1){
+	__m256i acc = _mm256_setzero_si256(); //hits of each 64-bit lane
+	long c = c0;
+	for(; c+8 <= c1; c+=8){
+		__m256i x[4];
+		philoxAVX2(seed, stream, c, x);
+		for(int s=0; s<4; s+=2){
+			acc = _mm256_sub_epi64(acc, insideDoubleAVX2(
+						_mm256_castsi256_si128(x[s]), _mm256_castsi256_si128(x[s+1])));
+			acc = _mm256_sub_epi64(acc, insideDoubleAVX2(
+						_mm256_extracti128_si256(x[s], 1), _mm256_extracti128_si256(x[s+1], 1)));
+		}
+	}
+	int64_t lanes[4];
+	_mm256_storeu_si256((__m256i *)lanes, acc);
+	long hits = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+	return hits + countersDoubleScalar(seed, stream, c, c1);
+}
+
+// Philox of counters c .. c+15 of stream, in words x[0..3]
+__attribute__((target("avx512f")))
+static inline void philoxAVX512(uint64_t seed, uint64_t stream, long c,
+		__m512i x[4]){
+	const __m512i m0 = _mm512_set1_epi32(M0), m1 = _mm512_set1_epi32(M1);
+	x[0] = _mm512_add_epi32(_mm512_set1_epi32((uint32_t)c),
+			_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+	x[1] = _mm512_set1_epi32((uint64_t)c >> 32);
+	x[2] = _mm512_set1_epi32((uint32_t)stream);
+	x[3] = _mm512_set1_epi32(stream >> 32);
+	uint32_t k0 = (uint32_t)seed, k1 = seed >> 32;
+	for(int r=0; r<ROUNDS; r++){
+		__m512i pe0 = _mm512_mul_epu32(x[0], m0);
+		__m512i po0 = _mm512_mul_epu32(_mm512_srli_epi64(x[0], 32), m0);
+		__m512i pe1 = _mm512_mul_epu32(x[2], m1);
+		__m512i po1 = _mm512_mul_epu32(_mm512_srli_epi64(x[2], 32), m1);
+		__m512i lo0 = _mm512_mask_blend_epi32(0xAAAA, pe0,
+				_mm512_slli_epi64(po0, 32));
+		__m512i hi0 = _mm512_mask_blend_epi32(0xAAAA,
+				_mm512_srli_epi64(pe0, 32), po0);
+		__m512i lo1 = _mm512_mask_blend_epi32(0xAAAA, pe1,
+				_mm512_slli_epi64(po1, 32));
+		__m512i hi1 = _mm512_mask_blend_epi32(0xAAAA,
+				_mm512_srli_epi64(pe1, 32), po1);
+		x[0] = _mm512_xor_si512(_mm512_xor_si512(hi1, x[1]),
+				_mm512_set1_epi32(k0));
+		x[1] = lo1;
+		x[2] = _mm512_xor_si512(_mm512_xor_si512(hi0, x[3]),
+				_mm512_set1_epi32(k1));
+		x[3] = lo0;
+		k0 += W0;
+		k1 += W1;
+	}
+}
+
+__attribute__((target("avx512f")))
+static inline __mmask16 insideFloatAVX512(__m512i wx, __m512i wy){
+	const __m512i sign = _mm512_set1_epi32(SIGN);
+	const __m512 scale = _mm512_set1_ps(0x1p-23f);
+	__m512 x = _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_srai_epi32(
+					_mm512_xor_si512(wx, sign), 8)), scale);
+	__m512 y = _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_srai_epi32(
+					_mm512_xor_si512(wy, sign), 8)), scale);
+	__m512 r = _mm512_add_ps(_mm512_mul_ps(x, x), _mm512_mul_ps(y, y));
+	return _mm512_cmp_ps_mask(r, _mm512_set1_ps(1.0f), _CMP_LE_OQ);
+}
+
+__attribute__((target("avx512f")))
+static inline __mmask8 insideDoubleAVX512(__m256i wx, __m256i wy){
+	const __m256i sign = _mm256_set1_epi32(SIGN);
+	const __m512d scale = _mm512_set1_pd(0x1p-31);
+	__m512d x = _mm512_mul_pd(_mm512_cvtepi32_pd(_mm256_xor_si256(wx, sign)),
+			scale);
+	__m512d y = _mm512_mul_pd(_mm512_cvtepi32_pd(_mm256_xor_si256(wy, sign)),
+			scale);
+	__m512d r = _mm512_add_pd(_mm512_mul_pd(x, x), _mm512_mul_pd(y, y));
+	return _mm512_cmp_pd_mask(r, _mm512_set1_pd(1.0), _CMP_LE_OQ);
+}
+
+__attribute__((target("avx512f")))
+static long countersFloatAVX512(uint64_t seed, uint64_t stream, long c0,
+		long c1){
+	const __m512i one = _mm512_set1_epi32(1);
+	__m512i acc = _mm512_setzero_si512(); //hits of each lane
+	long c = c0;
+	for(; c+16 <= c1; c+=16){
+		__m512i x[4];
+		philoxAVX512(seed, stream, c, x);
+		acc = _mm512_mask_add_epi32(acc, insideFloatAVX512(x[0], x[1]), acc, one);
+		acc = _mm512_mask_add_epi32(acc, insideFloatAVX512(x[2], x[3]), acc, one);
+	}
+	long hits = _mm512_reduce_add_epi32(acc);
+	return hits + countersFloatScalar(seed, stream, c, c1);
+}
+
+__attribute__((target("avx512f")))
+static long countersDoubleAVX512(uint64_t seed, uint64_t stream, long c0,
+		long c1){
+	const __m512i one = _mm512_set1_epi64(1);
+	__m512i acc = _mm512_setzero_si512(); //hits of each 64-bit lane
+	long c = c0;
+	for(; c+16 <= c1; c+=16){
+		__m512i x[4];
+		philoxAVX512(seed, stream, c, x);
+		for(int s=0; s<4; s+=2){
+			acc = _mm512_mask_add_epi64(acc, insideDoubleAVX512(
+						_mm512_castsi512_si256(x[s]), _mm512_castsi512_si256(x[s+1])),
+					acc, one);
+			acc = _mm512_mask_add_epi64(acc, insideDoubleAVX512(
+						_mm512_extracti64x4_epi64(x[s], 1),
+						_mm512_extracti64x4_epi64(x[s+1], 1)), acc, one);
+		}
+	}
+	long hits = _mm512_reduce_add_epi64(acc);
+	return hits + countersDoubleScalar(seed, stream, c, c1);
+}
+#endif
+
+static long hitsFloatScalar(uint64_t seed, long lo, long hi){
+	return countHits(countersFloatScalar, sampleFloat, seed, lo, hi);
+}
+
+static long hitsDoubleScalar(uint64_t seed, long lo, long hi){
+	return countHits(countersDoubleScalar, sampleDouble, seed, lo, hi);
+}
+
+#ifdef __x86_64__
+static long hitsFloatAVX2(uint64_t seed, long lo, long hi){
+	return countHits(countersFloatAVX2, sampleFloat, seed, lo, hi);
+}
+
+static long hitsDoubleAVX2(uint64_t seed, long lo, long hi){
+	return countHits(countersDoubleAVX2, sampleDouble, seed, lo, hi);
+}
+
+static long hitsFloatAVX512(uint64_t seed, long lo, long hi){
+	return countHits(countersFloatAVX512, sampleFloat, seed, lo, hi);
+}
+
+static long hitsDoubleAVX512(uint64_t seed, long lo, long hi){
+	return countHits(countersDoubleAVX512, sampleDouble, seed, lo, hi);
+}
+#endif
+
+const char *piISAName(enum PiISA isa){
+	static const char *names[PI_NUM_ISA] = {"scalar", "avx2", "avx512"};
+	return names[isa];
+}
+
+int piISASupported(enum PiISA isa){
+	#ifdef __x86_64__
+	__builtin_cpu_init();
+	if(isa == PI_AVX2)
+		return __builtin_cpu_supports("avx2");
+	if(isa == PI_AVX512)
+		return __builtin_cpu_supports("avx512f");
+	#endif
+	return isa == PI_SCALAR;
+}
+
+enum PiISA piBestISA(void){
+	enum PiISA isa = PI_NUM_ISA-1;
+	while(!piISASupported(isa))
+		isa--;
+	return isa;
+}
+
+PiKernel piKernelFloat(enum PiISA isa){
+	if(!piISASupported(isa))
+		return NULL;
+	#ifdef __x86_64__
+	if(isa == PI_AVX2)
+		return hitsFloatAVX2;
+	if(isa == PI_AVX512)
+		return hitsFloatAVX512;
+	#endif
+	return hitsFloatScalar;
+}
+
+PiKernel piKernelDouble(enum PiISA isa){
+	if(!piISASupported(isa))
+		return NULL;
+	#ifdef __x86_64__
+	if(isa == PI_AVX2)
+		return hitsDoubleAVX2;
+	if(isa == PI_AVX512)
+		return hitsDoubleAVX512;
+	#endif
+	return hitsDoubleScalar;
+}
@@ -0,0 +1,31 @@
+// Vectorized Monte Carlo pi kernels, used by piSIMD.c.
+// A kernel counts the random points (x,y) in [-1,1)^2 that fall inside
+// the unit circle, for samples lo .. hi-1. Sample i is made from words
+// 2(i%PI_BLOCK) and 2(i%PI_BLOCK)+1 of Philox stream i/PI_BLOCK (see
+// philox.h), as in piOMP.c, piOMPReduction.c and piForkJoin.c, so
+// counts are the same as theirs. Each Philox counter gives 2 samples,
+// and a vector of counters (8 with AVX2, 16 with AVX-512) is generated
+// in registers, converted to coordinates and tested at once, with hits
+// counted in integer lanes and added to a 64-bit total.
+// The float kernel uses the 24 high bits of each word as a coordinate,
+// with the same arithmetic as the pi programs, so its counts are exactly
+// theirs. The double kernel uses all 32 bits and double arithmetic.
+#ifndef PIKERNEL_H
+#define PIKERNEL_H
+#include <stdint.h>
+#define PI_BLOCK 1024 //samples per random stream
+
+// number of samples in [lo, hi) inside unit circle, with seed
+typedef long (*PiKernel)(uint64_t seed, long lo, long hi);
+
+enum PiISA {PI_SCALAR, PI_AVX2, PI_AVX512, PI_NUM_ISA};
+// name of instruction set
+const char *piISAName(enum PiISA isa);
+// 1 if instruction set is supported by processor
+int piISASupported(enum PiISA isa);
+// best supported instruction set
+enum PiISA piBestISA(void);
+// float or double kernel for instruction set, NULL if not supported
+PiKernel piKernelFloat(enum PiISA isa);
+PiKernel piKernelDouble(enum PiISA isa);
+#endif
@@ -18,51 +18,76 @@
  * -------------------------------------------------------------------
  * Implementation of estimation of pi using OpenMP
  * and reduction clause
+ * Random numbers come from the counter-based generator of philox.h:
+ * samples are divided into blocks of BLOCK, each with its own stream,
+ * so the estimate for a given seed is the same for any number of
+ * threads.
  */
  #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
+#include <stdint.h>
 #include <omp.h>
+#include "philox.h"
 
-float piEst(int n);
+#define BLOCK 1024 //samples per random stream
+
+//number of samples in unit circle of n random samples in square
+long piEst(long n);
+//number of samples in [lo, hi) inside unit circle
+long countHits(long lo, long hi);
+uint64_t seed; //of random numbers
 
 int main(int argc, char **argv){
 	struct timespec tstart,tend; 
   float timer;
 
 	if(argc < 2){
-		fprintf(stderr,"usage: %s n\n", argv[0]);
+		fprintf(stderr,"usage: %s n [seed]\n", argv[0]);
 		return 1;
 	}
-	int n = strtol(argv[1], NULL, 10);
+	long n = strtol(argv[1], NULL, 10);
+	seed = argc > 2 ? strtoull(argv[2], NULL, 10) : 1;
+	printf("seed=%llu\n", (unsigned long long)seed);
 
 	clock_gettime(CLOCK_MONOTONIC, &tstart);
-	float piEstimate = piEst(n)*4/n;
+	double piEstimate = (double)piEst(n)*4/n;
 	clock_gettime(CLOCK_MONOTONIC, &tend);
   timer = (tend.tv_sec-tstart.tv_sec) +
         (tend.tv_nsec-tstart.tv_nsec)*1.0e-9;
 
-	printf("pi is approx %f\n", piEstimate);
-	printf("time in s: %f\n", timer);
+	printf("pi is approx %.9f\n", piEstimate);
+	printf("time in s, using %d threads: %f\n", omp_get_max_threads(), timer);
+	printf("samples/s: %g\n", n/timer);
 	return 0;
 }
 
-float piEst(int n){
-	float sum=0.0;
-	#pragma omp parallel
-	{
-		int id = omp_get_thread_num();
-		struct timespec t;
-		clock_gettime(CLOCK_MONOTONIC, &t);
-		unsigned int seed = t.tv_nsec;
-		printf("thread %d, seed=%u\n", id, seed);
-		#pragma omp for reduction(+:sum)
-		for(int i=0; i<n; i++){
-			float x = (float)rand_r(&seed)/RAND_MAX*2-1;
-			float y = (float)rand_r(&seed)/RAND_MAX*2-1;
-			if(x*x + y*y <= 1.0)
-				sum++;
+long piEst(long n){
+	long sum = 0;
+	long nb = (n+BLOCK-1)/BLOCK; //number of blocks
+	#pragma omp parallel for reduction(+:sum)
+	for(long b=0; b<nb; b++)
+		sum += countHits(b*BLOCK, b < nb-1 ? (b+1)*BLOCK : n);
+	return sum;
+}
+
+long countHits(long lo, long hi){
+	float u[2*BLOCK];
+	long hits = 0;
+	//sample i is (x,y) from words 2(i%BLOCK) and 2(i%BLOCK)+1 of stream i/BLOCK
+	while(lo < hi){
+		long b = lo/BLOCK;
+		long first = lo - b*BLOCK;
+		long last = hi - b*BLOCK < BLOCK ? hi - b*BLOCK : BLOCK;
+		long m = 2*(last-first);
+		philoxUniform(seed, b, 2*first, u, m);
+		for(long i=0; i<m; i+=2){
+			float x = u[i]*2-1;
+			float y = u[i+1]*2-1;
+			if(x*x + y*y <= 1.0f)
+				hits++;
 		}
+		lo = b*BLOCK + last;
 	}
-	return sum;
+	return hits;
 }
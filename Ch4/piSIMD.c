@@ -0,0 +1,203 @@
+/* Copyright 2017 Eric Aubanel
+ * This file contains code implementing Algorithms 4.5 and 4.10 from
+ * Elements of Parallel Computing, by Eric Aubanel, 2016, CRC Press.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------
+ * Benchmark of the vectorized Monte Carlo pi kernels of piKernel.h
+ * against the loop of piOMP.c, piOMPReduction.c and piForkJoin.c.
+ * First each kernel (scalar, AVX2 and AVX-512, float and double) is
+ * run with the parallel loop and reduction of piOMPReduction.c. Then
+ * the loop and the best float kernel are run with each of the 3
+ * ways of dividing the work: per-thread sums (piOMP.c), reduction
+ * (piOMPReduction.c), and fork-join tasks with the work-stealing runtime
+ * (piForkJoin.c, WS_NUM_WORKERS workers).
+ * All use the same random numbers, so the float kernels must give
+ * exactly the number of hits of the loop.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <math.h>
+#include <stdint.h>
+#include <omp.h>
+#include "philox.h"
+#include "piKernel.h"
+#include "workSteal.h"
+
+// hits of n samples divided among threads or tasks
+typedef long (*Driver)(long n);
+// per-thread sums, as in piOMP.c
+long ompHits(long n);
+// reduction clause, as in piOMPReduction.c
+long reductionHits(long n);
+// recursive fork-join, as in piForkJoin.c
+long forkJoinHits(long n);
+long recHits(long lo, long n);
+typedef struct{
+	long lo, n;
+	long hits;
+} HitsArgs;
+void recHitsTask(void *arg);
+// loop of pi programs, with kernel signature
+long loopHits(uint64_t seed, long lo, long hi);
+// runs driver with kernel k, returns time in s and hits
+double timeDriver(Driver d, PiKernel k, long n, long *hits);
+void printRow(const char *label, const char *isa, long n, long hits,
+		double timer, double loopTime);
+
+PiKernel kernel; //used by drivers
+uint64_t seed; //of random numbers
+long cutoff; //of fork-join recursion
+
+int main(int argc, char **argv){
+	if(argc < 2){
+		fprintf(stderr,"usage: %s n [seed [cutoff]]\n", argv[0]);
+		return 1;
+	}
+	long n = strtol(argv[1], NULL, 10);
+	seed = argc > 2 ? strtoull(argv[2], NULL, 10) : 1;
+	cutoff = argc > 3 ? strtol(argv[3], NULL, 10) : 1 << 16;
+	if(n < 1 || cutoff < 1){
+		fprintf(stderr,"n and cutoff must be positive\n");
+		return 1;
+	}
+	wsInit(0);
+	printf("n = %ld, seed = %llu, %d threads, %d workers, cutoff %ld\n", n,
+			(unsigned long long)seed, omp_get_max_threads(), wsNumWorkers(), cutoff);
+
+	//kernels, with reduction
+	long loop;
+	double loopTime = timeDriver(reductionHits, loopHits, n, &loop);
+	printf("%-14s %-8s %12s %12s %10s %12s %8s\n", "kernel", "isa", "hits",
+			"pi error", "time (s)", "Msamples/s", "speedup");
+	printRow("loop", "scalar", n, loop, loopTime, loopTime);
+	for(int prec=0; prec<2; prec++)
+		for(enum PiISA isa=PI_SCALAR; isa<PI_NUM_ISA; isa++){
+			PiKernel k = prec ? piKernelDouble(isa) : piKernelFloat(isa);
+			if(!k)
+				continue;
+			long hits;
+			double timer = timeDriver(reductionHits, k, n, &hits);
+			printRow(prec ? "double" : "float", piISAName(isa), n, hits, timer,
+					loopTime);
+			if(!prec && hits != loop)
+				printf("float kernel hits differ from loop\n");
+		}
+
+	//ways of dividing work, with loop and best float kernel
+	Driver drivers[3] = {ompHits, reductionHits, forkJoinHits};
+	const char *names[3] = {"piOMP", "piOMPReduction", "piForkJoin"};
+	enum PiISA best = piBestISA();
+	printf("\n%-14s %-8s %12s %12s %10s %12s %8s\n", "program", "kernel",
+			"hits", "pi error", "time (s)", "Msamples/s", "speedup");
+	for(int d=0; d<3; d++){
+		long hits;
+		double timer = timeDriver(drivers[d], loopHits, n, &hits);
+		printRow(names[d], "loop", n, hits, timer, timer);
+		double kTime = timeDriver(drivers[d], piKernelFloat(best), n, &hits);
+		printRow(names[d], piISAName(best), n, hits, kTime, timer);
+	}
+	wsFinalize();
+	return 0;
+}
+
+void printRow(const char *label, const char *isa, long n, long hits,
+		double timer, double loopTime){
+	printf("%-14s %-8s %12ld %12.3e %10f %12.1f %8.2f\n", label, isa, hits,
+			fabs((double)hits*4/n - M_PI), timer, n/timer*1e-6, loopTime/timer);
+}
+
+double timeDriver(Driver d, PiKernel k, long n, long *hits){
+	struct timespec tstart,tend;
+	kernel = k;
+	clock_gettime(CLOCK_MONOTONIC, &tstart);
+	*hits = d(n);
+	clock_gettime(CLOCK_MONOTONIC, &tend);
+	return (tend.tv_sec-tstart.tv_sec) + (tend.tv_nsec-tstart.tv_nsec)*1.0e-9;
+}
+
+long ompHits(long n){
+	long sum = 0;
+	int nt = omp_get_max_threads();
+	long *psum = calloc(nt, sizeof(long));
+	long nb = (n+PI_BLOCK-1)/PI_BLOCK; //number of blocks
+	#pragma omp parallel
+	{
+		long localSum = 0;
+		int id = omp_get_thread_num();
+		#pragma omp for
+		for(long b=0; b<nb; b++)
+			localSum += kernel(seed, b*PI_BLOCK, b < nb-1 ? (b+1)*PI_BLOCK : n);
+		psum[id] = localSum;
+	}
+	for(int i=0; i<nt; i++)
+		sum += psum[i];
+	free(psum);
+	return sum;
+}
+
+long reductionHits(long n){
+	long sum = 0;
+	long nb = (n+PI_BLOCK-1)/PI_BLOCK; //number of blocks
+	#pragma omp parallel for reduction(+:sum)
+	for(long b=0; b<nb; b++)
+		sum += kernel(seed, b*PI_BLOCK, b < nb-1 ? (b+1)*PI_BLOCK : n);
+	return sum;
+}
+
+long forkJoinHits(long n){
+	HitsArgs args = {0, n, 0};
+	wsRun(recHitsTask, &args);
+	return args.hits;
+}
+
+long recHits(long lo, long n){
+	if(n < cutoff || n < 2)
+		return kernel(seed, lo, lo+n);
+	HitsArgs args = {lo, n/2, 0};
+	WsGroup g = WS_GROUP_INIT;
+	WsTask t;
+	wsSpawn(&g, &t, recHitsTask, &args);
+	long hits2 = recHits(lo+n/2, n-n/2);
+	wsSync(&g);
+	return args.hits + hits2;
+}
+
+void recHitsTask(void *arg){
+	HitsArgs *args = arg;
+	args->hits = recHits(args->lo, args->n);
+}
+
+long loopHits(uint64_t seed, long lo, long hi){
+	float u[2*PI_BLOCK];
+	long hits = 0;
+	//sample i is (x,y) from words 2(i%PI_BLOCK), 2(i%PI_BLOCK)+1 of stream i/PI_BLOCK
+	while(lo < hi){
+		long b = lo/PI_BLOCK;
+		long first = lo - b*PI_BLOCK;
+		long last = hi - b*PI_BLOCK < PI_BLOCK ? hi - b*PI_BLOCK : PI_BLOCK;
+		long m = 2*(last-first);
+		philoxUniform(seed, b, 2*first, u, m);
+		for(long i=0; i<m; i+=2){
+			float x = u[i]*2-1;
+			float y = u[i+1]*2-1;
+			if(x*x + y*y <= 1.0f)
+				hits++;
+		}
+		lo = b*PI_BLOCK + last;
+	}
+	return hits;
+}
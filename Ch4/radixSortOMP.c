@@ -0,0 +1,416 @@
+/* Copyright 2017 Eric Aubanel
+ * This file contains code extending Algorithms 4.13 and 5.1 from
+ * Elements of Parallel Computing, by Eric Aubanel, 2016, CRC Press.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------
+ * Radix sort of n unsigned 32 or 64-bit keys, optionally with a 32-bit
+ * payload moved along with each key, using SPMD style OpenMP with any
+ * number of threads. Keys are sorted 8 bits (one digit) at a time.
+ * In each pass every thread counts the digits in its part of the array
+ * (its histogram). The counts, ordered by digit then by thread, are
+ * scanned to give the position where each thread writes the keys with
+ * each digit, using the prefix sum of Algorithm 5.1 with the Hillis and
+ * Steele scan of Ch5/scanSPMDHS.c. Keys are then scattered to their
+ * positions through write-combining buffers: each thread collects keys
+ * in a small buffer per digit, and copies a full buffer (a cache line
+ * or more) at once, rather than writing to 256 places in memory.
+ * Passes where all keys have the same digit are skipped.
+ * LSD (least significant digit first) sorts all digits in parallel.
+ * MSD does one parallel pass on the most significant digit that
+ * differs, then each of the resulting 256 buckets is sorted by a
+ * sequential LSD sort, with buckets shared among threads.
+ * Both sorts are stable, so a key's payload can be its original index.
+ * Compares times with qsort, and checks results against qsort.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <omp.h>
+
+#define RADIX_BITS 8
+#define RADIX (1 << RADIX_BITS)
+#define MASK (RADIX-1)
+#define WC 16 //keys in write-combining buffer of each digit
+#define INSERTION 32 //buckets smaller than this sorted by insertion sort
+
+//Defines functions for keys of type K, with names ending in S:
+//histS counts digits at shift of a[lo..hi) in h
+//scatterS moves a[lo..hi) (and va if not NULL) to b (and vb), where
+//pos[d] is position in b of next key with digit d
+//insertionSortS sorts a[lo..hi) (and va if not NULL), stable
+//seqRadixS sorts a[lo..hi) (and va) by the low digits digits, using b
+//(and vb) as work array, result in a
+#define DEFINE_RADIX_SORT(K, S) \
+void hist##S(const K *a, long lo, long hi, int shift, long *h){ \
+	for(int d=0; d<RADIX; d++) \
+		h[d] = 0; \
+	for(long i=lo; i<hi; i++) \
+		h[(a[i] >> shift) & MASK]++; \
+} \
+\
+void scatter##S(const K *a, const uint32_t *va, long lo, long hi, int shift, \
+		long *pos, K *b, uint32_t *vb){ \
+	K buf[RADIX][WC]; \
+	uint32_t vbuf[RADIX][WC]; \
+	int fill[RADIX]; \
+	for(int d=0; d<RADIX; d++) \
+		fill[d] = 0; \
+	for(long i=lo; i<hi; i++){ \
+		K k = a[i]; \
+		int d = (k >> shift) & MASK; \
+		int f = fill[d]; \
+		buf[d][f] = k; \
+		if(va) \
+			vbuf[d][f] = va[i]; \
+		if(++f == WC){ \
+			memcpy(b+pos[d], buf[d], WC*sizeof(K)); \
+			if(va) \
+				memcpy(vb+pos[d], vbuf[d], WC*sizeof(uint32_t)); \
+			pos[d] += WC; \
+			f = 0; \
+		} \
+		fill[d] = f; \
+	} \
+	for(int d=0; d<RADIX; d++){ \
+		memcpy(b+pos[d], buf[d], fill[d]*sizeof(K)); \
+		if(va) \
+			memcpy(vb+pos[d], vbuf[d], fill[d]*sizeof(uint32_t)); \
+		pos[d] += fill[d]; \
+	} \
+} \
+\
+void insertionSort##S(K *a, uint32_t *va, long lo, long hi){ \
+	for(long i=lo+1; i<hi; i++){ \
+		K x = a[i]; \
+		uint32_t v = va ? va[i] : 0; \
+		long j = i; \
+		for(; j>lo && a[j-1] > x; j--){ \
+			a[j] = a[j-1]; \
+			if(va) \
+				va[j] = va[j-1]; \
+		} \
+		a[j] = x; \
+		if(va) \
+			va[j] = v; \
+	} \
+} \
+\
+void seqRadix##S(K *a, K *b, uint32_t *va, uint32_t *vb, long lo, long hi, \
+		int digits){ \
+	long n = hi-lo; \
+	if(n < INSERTION){ \
+		insertionSort##S(a, va, lo, hi); \
+		return; \
+	} \
+	K *from = a, *to = b; \
+	uint32_t *vfrom = va, *vto = vb; \
+	long h[RADIX]; \
+	for(int p=0; p<digits; p++){ \
+		hist##S(from, lo, hi, RADIX_BITS*p, h); \
+		int skip = 0; \
+		for(int d=0; d<RADIX; d++) \
+			skip |= h[d] == n; \
+		if(skip) \
+			continue; \
+		exclusivePrefixSum(h, RADIX); \
+		for(int d=0; d<RADIX; d++) \
+			h[d] += lo; \
+		scatter##S(from, vfrom, lo, hi, RADIX_BITS*p, h, to, vto); \
+		K *t = from; from = to; to = t; \
+		uint32_t *vt = vfrom; vfrom = vto; vto = vt; \
+	} \
+	if(from != a){ \
+		memcpy(a+lo, from+lo, n*sizeof(K)); \
+		if(va) \
+			memcpy(va+lo, vfrom+lo, n*sizeof(uint32_t)); \
+	} \
+}
+
+//Performs exclusive prefix sum of array a of length n, returns sum
+long exclusivePrefixSum(long *a, int n);
+DEFINE_RADIX_SORT(uint32_t, 32)
+DEFINE_RADIX_SORT(uint64_t, 64)
+
+//Performs parallel (OpenMP) inclusive prefix sum
+//of p values (one per thread) using Hillis and Steele algorithm.
+//Uses extra array acopy and returns pointer to copy (a or acopy)
+//with final result. Contains orphaned OpenMP directive (barrier).
+long *parPrefixSumHS(long *a, long *acopy, int p, int id);
+//Algorithm 5.1: exclusive prefix sum of a[0..n), where n divisible by
+//number of threads nt, s and scopy arrays of length nt.
+//Contains orphaned OpenMP directives (barrier)
+void parScan(long *a, long n, long *s, long *scopy, int id, int nt);
+//One pass of parallel radix sort on digit at shift, moving keys (64-bit
+//if wide) from a to b, and payloads from va to vb if va not NULL.
+//cnt has space for RADIX*nt+1 counts, with cnt[RADIX*nt] = n. Afterwards
+//keys with digit d are in b[cnt[d*nt]..cnt[(d+1)*nt]).
+//Returns 0, without moving keys, if all keys have the same digit.
+//Contains orphaned OpenMP directives (barrier)
+int parPass(void *a, uint32_t *va, void *b, uint32_t *vb, int wide, long n,
+		int shift, long *cnt, long *s, long *scopy, int id, int nt);
+//Sorts n keys (64-bit if wide) in a, with payloads in va if not NULL,
+//using b and vb as work arrays. Uses MSD sort if msd, otherwise LSD.
+//Returns 1 if result in b and vb, 0 if in a and va
+int radixSort(void *a, void *b, uint32_t *va, uint32_t *vb, long n, int wide,
+		int msd);
+//comparison functions for sequential sort
+int compare32(const void * arg1, const void * arg2);
+int compare64(const void * arg1, const void * arg2);
+//returns key i of array of 32 or 64-bit (if wide) keys
+uint64_t keyAt(const void *a, long i, int wide);
+//checks that keys are the same as sorted, and that payloads (if vals
+//not NULL) are the original indices of the keys in orig, in increasing
+//order for equal keys
+int verify(const void *keys, const uint32_t *vals, const void *sorted,
+		const void *orig, long n, int wide);
+//time in seconds since t
+double elapsed(struct timespec t);
+
+int main(int argc, char **argv){
+	void *a, *b; //array to be sorted and work array
+	void *c; //copy of unsorted array
+	void *ks; //array used for sequential sort
+	uint32_t *va = NULL, *vb = NULL; //payloads
+	long n; //number of keys
+	int bits = 32; //bits in key
+	int payload = 0;
+
+	struct timespec tstart;
+	float timer;
+
+	if(argc < 2){
+		fprintf(stderr,"usage: %s n [bits [payload]]\n", argv[0]);
+		fprintf(stderr,"bits is 32 or 64, payload 1 to sort key and payload\n");
+		return 1;
+	}
+	n = strtol(argv[1], NULL, 10);
+	if(argc > 2)
+		bits = strtol(argv[2], NULL, 10);
+	if(argc > 3)
+		payload = strtol(argv[3], NULL, 10);
+	if(n < 1 || n > 0x7fffffff || (bits != 32 && bits != 64)){
+		fprintf(stderr,"n must be between 1 and 2^31-1 and bits 32 or 64\n");
+		return 1;
+	}
+	int wide = bits == 64;
+	size_t size = wide ? sizeof(uint64_t) : sizeof(uint32_t);
+	int nt = omp_get_max_threads();
+	a = malloc(n*size);
+	b = malloc(n*size);
+	c = malloc(n*size);
+	ks = malloc(n*size);
+	if(payload){
+		va = malloc(n*sizeof(uint32_t));
+		vb = malloc(n*sizeof(uint32_t));
+	}
+	if(a == NULL || b == NULL || c == NULL || ks == NULL
+			|| (payload && (va == NULL || vb == NULL))){
+		fprintf(stderr,"couldn't allocate arrays of %ld keys\n", n);
+		return 1;
+	}
+	srand(time(NULL));
+	for(long i=0; i<n; i++)
+		if(wide)
+			((uint64_t *)c)[i] = ((uint64_t)rand() << 42)
+					^ ((uint64_t)rand() << 21) ^ rand();
+		else
+			((uint32_t *)c)[i] = ((uint32_t)rand() << 16) ^ rand();
+
+	printf("n = %ld, %d-bit keys%s, %d threads\n", n, bits,
+			payload ? " with 32-bit payload" : "", nt);
+	printf("%-24s %12s %12s %8s\n", "sort", "time (s)", "Mkeys/s", "speedup");
+
+	memcpy(ks, c, n*size);
+	clock_gettime(CLOCK_MONOTONIC, &tstart);
+	qsort(ks, n, size, wide ? compare64 : compare32);
+	float qsortTime = elapsed(tstart);
+	printf("%-24s %12f %12.1f %8.2f\n", payload ? "qsort (keys only)" : "qsort",
+			qsortTime, n/qsortTime*1e-6, 1.0);
+
+	const char *label[] = {"LSD radix, 1 thread", "LSD radix",
+			"MSD radix, 1 thread", "MSD radix"};
+	for(int s=0; s<4; s++){
+		memcpy(a, c, n*size);
+		if(payload)
+			for(long i=0; i<n; i++)
+				va[i] = i;
+		if(s%2 == 0)
+			omp_set_num_threads(1);
+		clock_gettime(CLOCK_MONOTONIC, &tstart);
+		int inB = radixSort(a, b, va, vb, n, wide, s >= 2);
+		timer = elapsed(tstart);
+		omp_set_num_threads(nt);
+		printf("%-24s %12f %12.1f %8.2f\n", label[s], timer, n/timer*1e-6,
+				qsortTime/timer);
+		if(!verify(inB ? b : a, inB ? vb : va, ks, c, n, wide))
+			printf("%s result differs from qsort\n", label[s]);
+	}
+	return 0;
+}
+
+double elapsed(struct timespec t){
+	struct timespec tend;
+	clock_gettime(CLOCK_MONOTONIC, &tend);
+	return (tend.tv_sec-t.tv_sec) + (tend.tv_nsec-t.tv_nsec)*1.0e-9;
+}
+
+int radixSort(void *a, void *b, uint32_t *va, uint32_t *vb, long n, int wide,
+		int msd){
+	int nt = omp_get_max_threads();
+	if(nt > n)
+		nt = n;
+	int digits = wide ? 8 : 4;
+	long *cnt = malloc((RADIX*nt+1)*sizeof(long));
+	long s[nt], scopy[nt]; //scopy needed for prefix sum
+	if(!cnt){
+		fprintf(stderr,"couldn't allocate memory\n");
+		exit(1);
+	}
+	cnt[RADIX*nt] = n;
+	int inB = 0;
+	#pragma omp parallel num_threads(nt) firstprivate(a, b, va, vb)
+	{
+		int id = omp_get_thread_num();
+		int moved = 0; //number of passes that moved keys
+		if(!msd){
+			for(int p=0; p<digits; p++)
+				if(parPass(a, va, b, vb, wide, n, RADIX_BITS*p, cnt, s, scopy, id,
+						nt)){
+					void *t = a; a = b; b = t;
+					uint32_t *vt = va; va = vb; vb = vt;
+					moved++;
+				}
+		} else{
+			//most significant digit that isn't the same for all keys
+			int p = digits-1;
+			for(; p>=0; p--)
+				if(parPass(a, va, b, vb, wide, n, RADIX_BITS*p, cnt, s, scopy, id,
+						nt))
+					break;
+			if(p > 0){
+				#pragma omp for schedule(dynamic)
+				for(int d=0; d<RADIX; d++)
+					if(wide)
+						seqRadix64(b, a, vb, va, cnt[d*nt], cnt[(d+1)*nt], p);
+					else
+						seqRadix32(b, a, vb, va, cnt[d*nt], cnt[(d+1)*nt], p);
+			}
+			moved = p >= 0;
+		}
+		if(!id)
+			inB = moved%2;
+	}
+	free(cnt);
+	return inB;
+}
+
+int parPass(void *a, uint32_t *va, void *b, uint32_t *vb, int wide, long n,
+		int shift, long *cnt, long *s, long *scopy, int id, int nt){
+	long lo = id*n/nt;
+	long hi = (id+1)*n/nt;
+	long h[RADIX];
+	if(wide)
+		hist64(a, lo, hi, shift, h);
+	else
+		hist32(a, lo, hi, shift, h);
+	for(int d=0; d<RADIX; d++)
+		cnt[d*nt+id] = h[d];
+	#pragma omp barrier
+	parScan(cnt, RADIX*nt, s, scopy, id, nt);
+	for(int d=0; d<RADIX; d++)
+		if(cnt[(d+1)*nt] - cnt[d*nt] == n){
+			//every thread must be done with cnt before it's reused
+			#pragma omp barrier
+			return 0;
+		}
+	for(int d=0; d<RADIX; d++)
+		h[d] = cnt[d*nt+id];
+	if(wide)
+		scatter64(a, va, lo, hi, shift, h, b, vb);
+	else
+		scatter32(a, va, lo, hi, shift, h, b, vb);
+	#pragma omp barrier
+	return 1;
+}
+
+void parScan(long *a, long n, long *s, long *scopy, int id, int nt){
+	long np = n/nt; //number of elements per thread
+	long start = id*np;
+	s[id] = exclusivePrefixSum(a+start, np);
+	#pragma omp barrier
+	long *t = parPrefixSumHS(s, scopy, nt, id);
+	if(id)
+		for(long j=0; j<np; j++)
+			a[start+j] += t[id-1];
+	#pragma omp barrier
+}
+
+long exclusivePrefixSum(long *a, int n){
+	long sum = 0;
+	for(int i=0; i<n; i++){
+		long t = a[i];
+		a[i] = sum;
+		sum += t;
+	}
+	return sum;
+}
+
+long *parPrefixSumHS(long *a, long *acopy, int p, int id){
+	long *s;
+	for(int j=1;j<p;j<<=1){
+		if(id >= j)
+			acopy[id] = a[id-j]+a[id];
+		else
+			acopy[id] = a[id];
+		s = a;
+		a = acopy;
+		acopy = s;
+	#pragma omp barrier
+	}
+	return a;
+}
+
+int compare32(const void * arg1, const void * arg2){
+	const uint32_t x = * (const uint32_t *)arg1;
+	const uint32_t y = * (const uint32_t *)arg2;
+	return (x > y) - (x < y);
+}
+
+int compare64(const void * arg1, const void * arg2){
+	const uint64_t x = * (const uint64_t *)arg1;
+	const uint64_t y = * (const uint64_t *)arg2;
+	return (x > y) - (x < y);
+}
+
+uint64_t keyAt(const void *a, long i, int wide){
+	return wide ? ((const uint64_t *)a)[i] : ((const uint32_t *)a)[i];
+}
+
+int verify(const void *keys, const uint32_t *vals, const void *sorted,
+		const void *orig, long n, int wide){
+	if(memcmp(keys, sorted, n*(wide ? sizeof(uint64_t) : sizeof(uint32_t))))
+		return 0;
+	if(vals)
+		for(long i=0; i<n; i++)
+			if(vals[i] >= n || keyAt(orig, vals[i], wide) != keyAt(keys, i, wide)
+					|| (i > 0 && keyAt(keys, i, wide) == keyAt(keys, i-1, wide)
+					&& vals[i] <= vals[i-1]))
+				return 0;
+	return 1;
+}
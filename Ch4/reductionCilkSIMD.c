@@ -18,12 +18,15 @@
  * -------------------------------------------------------------------
  * Implementation of divergence-free reduction using Cilk Plus
  * For an array of 2^n integers
- * If SIMD not defined, uses array notation
- * If SIMD defined (compile with -DSIMD), uses SIMD pragma
+ * If SIMD not defined and compiler has Cilk Plus, uses array notation
+ * If SIMD defined (compile with -DSIMD), or compiler lacks Cilk Plus (as
+ * current gcc), uses OpenMP SIMD pragma (compile with -fopenmp-simd)
  */
 #include <stdio.h>
 #include <stdlib.h>
+#ifdef __cilk
 #include <cilk/cilk.h>
+#endif
 #include <time.h>
 
 int main(int argc, char **argv){
@@ -51,8 +54,8 @@ int main(int argc, char **argv){
 	clock_gettime(CLOCK_MONOTONIC, &tstart);
 	for (int k=exp-1; k>=0; k--) {
 		int j = 1<<k;
-	#ifdef SIMD
-		#pragma simd
+	#if defined(SIMD) || !defined(__cilk)
+		#pragma omp simd
 		for(int i=0; i<j; i++)
 			a[i] += a[i+j];	
 	#else
@@ -0,0 +1,329 @@
+/* Copyright 2017 Eric Aubanel
+ * This file contains code extending Algorithms 3.2 and 3.3 from
+ * Elements of Parallel Computing, by Eric Aubanel, 2016, CRC Press.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------
+ * MPI sample sort of n ints distributed over p processes, using
+ * regular sampling (PSRS):
+ * 1. each process sorts its keys with mergeSort (Algorithm 3.2)
+ * 2. each process picks p samples at regular positions in its sorted
+ *    keys, process 0 gathers and sorts them, and broadcasts the p-1
+ *    splitters, taken at regular positions in the sorted samples
+ * 3. each process splits its keys into p buckets, and bucket j is sent
+ *    to process j with MPI_Alltoallv
+ * 4. each process merges the p sorted runs it receives with merge
+ *    (Algorithm 3.3)
+ * To handle duplicate keys, each key is ordered by (key, process, index
+ * among equal keys in the process), so all keys are distinct and a run
+ * of equal keys can be divided among processes. This order is implicit
+ * in the sorted keys, so no extra data is sent. With regular sampling no
+ * process receives more than about 2n/p keys, whatever the distribution,
+ * including keys that are all equal. The split isn't exact, though: with
+ * splitters in the middle of each group of p samples, all-equal keys
+ * give process 0 the keys of process 0 and part of those of process 1
+ * (max imbalance 1.375 for p = 8).
+ * Outputs time for each phase and number of keys received by each process
+ * (imbalance is the ratio to n/p), and verifies that the keys are sorted
+ * and are the same as before sorting (with checksums).
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include "mpi.h"
+
+//key ordered by (key, rank, occurrence among equal keys in rank)
+typedef struct{
+	int key;
+	int rank;
+	int occ;
+} Sample;
+
+/*sort elements of a with index i in [lower .. upper) into array b
+ * array a is modified
+ */
+void mergeSort(int *a, int lower, int upper, int *b);
+//merge a[lower .. mid) and a[mid .. upper) into b
+void merge(int *a, int lower, int mid, int upper, int *b);
+//index of first element of sorted a[0..m) >= key (lower) or > key (upper)
+int lowerBound(const int *a, int m, int key);
+int upperBound(const int *a, int m, int key);
+//generate m keys of process id with given distribution
+void generate(int *a, int m, const char *dist, int id, int p);
+//comparison function for sorting samples
+int compareSample(const void *arg1, const void *arg2);
+//sum and sum of squares of keys, for verification
+void checksum(const int *a, int m, uint64_t sum[2]);
+
+int main(int argc, char **argv){
+	int *a; //my keys
+	int *b; //array used for merging
+	int id; //my id
+	int p; //number of processes
+	long n; //total number of keys
+	double time[5]; //sort, splitters, exchange, merge, total
+
+	MPI_Init(&argc, &argv);
+	MPI_Comm_rank(MPI_COMM_WORLD, &id);
+	MPI_Comm_size(MPI_COMM_WORLD, &p);
+
+	if(argc < 2){
+		if(!id){
+			fprintf(stderr,"usage: %s n [distribution]\n", argv[0]);
+			fprintf(stderr,"distribution: uniform (default), skewed, dup, equal, "
+					"reversed\n");
+		}
+		MPI_Finalize();
+		return 1;
+	}
+	n = strtol(argv[1], NULL, 10);
+	const char *dist = argc > 2 ? argv[2] : "uniform";
+	if(n < p || n/p > 0x3fffffff){
+		if(!id) fprintf(stderr,"n must be between p and p*2^30\n");
+		MPI_Finalize();
+		return 1;
+	}
+	int m = (id+1)*n/p - id*n/p; //number of my keys
+	a = malloc(m*sizeof(int));
+	b = malloc(m*sizeof(int));
+	if(a == NULL || b == NULL){
+		fprintf(stderr,"couldn't allocate array of %d ints\n", m);
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+	generate(a, m, dist, id, p);
+	uint64_t sumBefore[2], sumAfter[2];
+	checksum(a, m, sumBefore);
+	MPI_Allreduce(MPI_IN_PLACE, sumBefore, 2, MPI_UINT64_T, MPI_SUM,
+			MPI_COMM_WORLD);
+
+	MPI_Barrier(MPI_COMM_WORLD);
+	double t0 = MPI_Wtime();
+	//1. local sort, result in b
+	memcpy(b, a, m*sizeof(int));
+	mergeSort(a, 0, m, b);
+	double t1 = MPI_Wtime();
+
+	//2. regular samples, gathered and sorted by process 0
+	Sample *samples = malloc(p*sizeof(Sample));
+	Sample *all = malloc(p*p*sizeof(Sample));
+	Sample *splitters = malloc(p*sizeof(Sample));
+	if(!samples || !all || !splitters){
+		fprintf(stderr,"couldn't allocate memory\n");
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+	for(int j=0; j<p; j++){
+		int i = (long)j*m/p;
+		samples[j].key = b[i];
+		samples[j].rank = id;
+		samples[j].occ = i - lowerBound(b, m, b[i]);
+	}
+	MPI_Gather(samples, 3*p, MPI_INT, all, 3*p, MPI_INT, 0, MPI_COMM_WORLD);
+	if(!id){
+		qsort(all, p*p, sizeof(Sample), compareSample);
+		for(int j=1; j<p; j++)
+			splitters[j-1] = all[j*p + p/2 - 1];
+	}
+	MPI_Bcast(splitters, 3*(p-1), MPI_INT, 0, MPI_COMM_WORLD);
+	double t2 = MPI_Wtime();
+
+	//3. split into buckets and exchange
+	int *sendCount = malloc(p*sizeof(int));
+	int *sendDispl = malloc(p*sizeof(int));
+	int *recvCount = malloc(p*sizeof(int));
+	int *recvDispl = malloc((p+1)*sizeof(int));
+	if(!sendCount || !sendDispl || !recvCount || !recvDispl){
+		fprintf(stderr,"couldn't allocate memory\n");
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+	sendDispl[0] = 0;
+	for(int j=0; j<p-1; j++){
+		//number of my keys that come before splitter j
+		Sample s = splitters[j];
+		int lo = lowerBound(b, m, s.key);
+		int hi = upperBound(b, m, s.key);
+		int bound = id < s.rank ? hi : id > s.rank ? lo
+				: (lo + s.occ < hi ? lo + s.occ : hi);
+		sendCount[j] = bound - sendDispl[j];
+		sendDispl[j+1] = bound;
+	}
+	sendCount[p-1] = m - sendDispl[p-1];
+	MPI_Alltoall(sendCount, 1, MPI_INT, recvCount, 1, MPI_INT, MPI_COMM_WORLD);
+	recvDispl[0] = 0;
+	for(int j=0; j<p; j++)
+		recvDispl[j+1] = recvDispl[j] + recvCount[j];
+	int r = recvDispl[p]; //number of keys I receive
+	int *c = malloc((r > 0 ? r : 1)*sizeof(int));
+	int *d = malloc((r > 0 ? r : 1)*sizeof(int));
+	if(!c || !d){
+		fprintf(stderr,"couldn't allocate array of %d ints\n", r);
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+	MPI_Alltoallv(b, sendCount, sendDispl, MPI_INT, c, recvCount, recvDispl,
+			MPI_INT, MPI_COMM_WORLD);
+	free(a);
+	free(b);
+	double t3 = MPI_Wtime();
+
+	//4. merge sorted runs pairwise, run j from process j
+	for(int w=1; w<p; w*=2){
+		for(int j=0; j<p; j+=2*w){
+			int mid = recvDispl[j+w < p ? j+w : p];
+			int upper = recvDispl[j+2*w < p ? j+2*w : p];
+			merge(c, recvDispl[j], mid, upper, d);
+		}
+		int *temp = c;
+		c = d;
+		d = temp;
+	}
+	double t4 = MPI_Wtime();
+	time[0] = t1-t0;
+	time[1] = t2-t1;
+	time[2] = t3-t2;
+	time[3] = t4-t3;
+	time[4] = t4-t0;
+
+	//verify: sorted locally, across processes, and same keys
+	int ok = 1;
+	for(int i=1; i<r; i++)
+		if(c[i-1] > c[i])
+			ok = 0;
+	checksum(c, r, sumAfter);
+	MPI_Allreduce(MPI_IN_PLACE, sumAfter, 2, MPI_UINT64_T, MPI_SUM,
+			MPI_COMM_WORLD);
+	int ends[3] = {r, r ? c[0] : 0, r ? c[r-1] : 0}; //count, first, last
+	int *allEnds = malloc(3*p*sizeof(int));
+	double *allTimes = malloc(5*p*sizeof(double));
+	if(!allEnds || !allTimes){
+		fprintf(stderr,"couldn't allocate memory\n");
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+	MPI_Gather(ends, 3, MPI_INT, allEnds, 3, MPI_INT, 0, MPI_COMM_WORLD);
+	MPI_Gather(time, 5, MPI_DOUBLE, allTimes, 5, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+	MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+
+	if(!id){
+		printf("n = %ld, %d processes, %s keys\n", n, p, dist);
+		double maxTime = 0, maxKeys = 0;
+		printf("%6s %12s %10s %10s %10s %10s %10s\n", "rank", "keys", "imbalance",
+				"sort", "splitters", "exchange", "merge");
+		for(int j=0; j<p; j++){
+			double *t = allTimes + 5*j;
+			int keys = allEnds[3*j];
+			printf("%6d %12d %10.3f %10f %10f %10f %10f\n", j, keys,
+					keys/((double)n/p), t[0], t[1], t[2], t[3]);
+			if(t[4] > maxTime)
+				maxTime = t[4];
+			if(keys > maxKeys)
+				maxKeys = keys;
+		}
+		printf("max imbalance: %.3f\n", maxKeys/((double)n/p));
+		printf("parallel time in s: %f\n", maxTime);
+		//last key of each process <= first key of next nonempty process
+		int last = -1;
+		for(int j=0; j<p; j++)
+			if(allEnds[3*j] > 0){
+				if(last >= 0 && allEnds[3*last+2] > allEnds[3*j+1])
+					ok = 0;
+				last = j;
+			}
+		if(ok && sumBefore[0] == sumAfter[0] && sumBefore[1] == sumAfter[1])
+			printf("result verified\n");
+		else
+			printf("result not sorted, or keys differ from original keys\n");
+	}
+	MPI_Finalize();
+	return 0;
+}
+
+void generate(int *a, int m, const char *dist, int id, int p){
+	srand(id+1);
+	for(int i=0; i<m; i++){
+		double u = rand()/(RAND_MAX+1.0);
+		if(!strcmp(dist, "skewed"))
+			a[i] = RAND_MAX*pow(u, 8); //most keys small
+		else if(!strcmp(dist, "dup"))
+			a[i] = rand()%8;
+		else if(!strcmp(dist, "equal"))
+			a[i] = 42;
+		else if(!strcmp(dist, "reversed"))
+			//process id has keys in range of process p-1-id
+			a[i] = (p-1-id + u)*(RAND_MAX/p);
+		else
+			a[i] = rand();
+	}
+}
+
+void checksum(const int *a, int m, uint64_t sum[2]){
+	sum[0] = sum[1] = 0;
+	for(int i=0; i<m; i++){
+		uint64_t x = (uint32_t)a[i];
+		sum[0] += x;
+		sum[1] += x*x;
+	}
+}
+
+int compareSample(const void *arg1, const void *arg2){
+	const Sample *x = arg1;
+	const Sample *y = arg2;
+	if(x->key != y->key)
+		return x->key < y->key ? -1 : 1;
+	if(x->rank != y->rank)
+		return x->rank < y->rank ? -1 : 1;
+	return (x->occ > y->occ) - (x->occ < y->occ);
+}
+
+int lowerBound(const int *a, int m, int key){
+	int lo = 0, hi = m;
+	while(lo < hi){
+		int mid = (lo+hi)/2;
+		if(a[mid] < key)
+			lo = mid+1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+int upperBound(const int *a, int m, int key){
+	int lo = 0, hi = m;
+	while(lo < hi){
+		int mid = (lo+hi)/2;
+		if(a[mid] <= key)
+			lo = mid+1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+void mergeSort(int *a, int lower, int upper, int *b){
+	if(upper - lower < 2)
+		return;
+	int mid = (upper + lower)/2;
+	mergeSort(b, lower, mid, a);
+	mergeSort(b, mid, upper, a);
+	merge(a, lower, mid, upper, b);
+}
+
+void merge(int *a, int lower, int mid, int upper, int *b){
+	int i = lower, j = mid;
+	for(int k=lower; k<upper; k++)
+		if((i < mid) && ((j >= upper) || (a[i] <= a[j])))
+			b[k] = a[i++];
+		else
+			b[k] = a[j++];
+}
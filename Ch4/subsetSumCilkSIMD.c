@@ -18,13 +18,16 @@
  * -------------------------------------------------------------------
  * Implementation of T/F subset sum problem using dynamic programming
  * using SIMD with Cilk Plus
- * If SIMD not defined, uses array notation
- * If SIMD defined (compile with -DSIMD), uses SIMD pragma
+ * If SIMD not defined and compiler has Cilk Plus, uses array notation
+ * If SIMD defined (compile with -DSIMD), or compiler lacks Cilk Plus (as
+ * current gcc), uses OpenMP SIMD pragma (compile with -fopenmp-simd)
  */
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
+#ifdef __cilk
 #include <cilk/cilk.h>
+#endif
 
 int main(int argc, char **argv){
   int R; // max magnitude of elements in set
@@ -80,12 +83,12 @@ int main(int argc, char **argv){
 	*/
 	clock_gettime(CLOCK_MONOTONIC, &tstart);
 	for(int i=2;i<=n;i++){
-		#ifdef SIMD
-		#pragma SIMD
+		#if defined(SIMD) || !defined(__cilk)
+		#pragma omp simd
     for(int j=1; j<s[i];j++){
       F[i*m+j] = F[(i-1)*m+j];
     }
-		#pragma SIMD
+		#pragma omp simd
     for(int j=s[i];j<=S;j++){
       F[i*m+j] = F[(i-1)*m+j] + F[(i-1)*m+j-s[i]];
     }
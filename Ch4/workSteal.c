@@ -0,0 +1,269 @@
+// Implementation of work-stealing fork-join runtime (see workSteal.h).
+// The deque is the Chase-Lev deque with the C11 memory orderings of
+// Le, Pop, Cohen and Zappa Nardelli, "Correct and Efficient Work-Stealing
+// for Weak Memory Models", PPoPP 2013, with a fixed size array.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include "workSteal.h"
+
+#define DEQUE_SIZE 4096 //power of 2, task run immediately if deque full
+#define MAX_WORKERS 1024
+
+typedef struct{
+	_Alignas(64) atomic_long top; //next task to steal
+	char pad1[64-sizeof(atomic_long)];
+	atomic_long bottom; //next free slot
+	char pad2[64-sizeof(atomic_long)];
+	_Atomic(WsTask *) buf[DEQUE_SIZE];
+	unsigned seed; //for choosing victims
+	long tasks, steals, attempts; //statistics
+	double idle; //time in s with no task to run
+} Worker;
+
+static Worker *workers;
+static int numWorkers;
+static pthread_t threads[MAX_WORKERS];
+static __thread int myId; //0 for thread calling wsInit
+static atomic_int active; //wsRun in progress
+static atomic_int quit;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake = PTHREAD_COND_INITIALIZER;
+static int parked; //workers waiting for wsRun, protected by lock
+static pthread_cond_t allParked = PTHREAD_COND_INITIALIZER;
+
+// push t onto bottom of deque of w, returns 0 if deque full
+static int push(Worker *w, WsTask *t);
+// take task from bottom of deque of w, NULL if empty
+static WsTask *take(Worker *w);
+// steal task from top of deque of w, NULL if empty or another thief won
+static WsTask *steal(Worker *w);
+// run task and signal its group
+static void runTask(Worker *w, WsTask *t);
+// steal a task from a random worker and run it, returns 1 if successful
+static int stealAndRun(Worker *w);
+// loop of worker threads
+static void *workerLoop(void *arg);
+// time in s
+static double now(void);
+
+static int push(Worker *w, WsTask *t){
+	long b = atomic_load_explicit(&w->bottom, memory_order_relaxed);
+	long top = atomic_load_explicit(&w->top, memory_order_acquire);
+	if(b - top >= DEQUE_SIZE)
+		return 0;
+	atomic_store_explicit(&w->buf[b & (DEQUE_SIZE-1)], t, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	atomic_store_explicit(&w->bottom, b+1, memory_order_relaxed);
+	return 1;
+}
+
+static WsTask *take(Worker *w){
+	long b = atomic_load_explicit(&w->bottom, memory_order_relaxed) - 1;
+	atomic_store_explicit(&w->bottom, b, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	long top = atomic_load_explicit(&w->top, memory_order_relaxed);
+	WsTask *t = NULL;
+	if(top <= b){
+		t = atomic_load_explicit(&w->buf[b & (DEQUE_SIZE-1)], memory_order_relaxed);
+		if(top == b){
+			//last task, race with thieves
+			if(!atomic_compare_exchange_strong_explicit(&w->top, &top, top+1,
+					memory_order_seq_cst, memory_order_relaxed))
+				t = NULL;
+			atomic_store_explicit(&w->bottom, b+1, memory_order_relaxed);
+		}
+	} else
+		atomic_store_explicit(&w->bottom, b+1, memory_order_relaxed);
+	return t;
+}
+
+static WsTask *steal(Worker *w){
+	long top = atomic_load_explicit(&w->top, memory_order_acquire);
+	atomic_thread_fence(memory_order_seq_cst);
+	long b = atomic_load_explicit(&w->bottom, memory_order_acquire);
+	if(top >= b)
+		return NULL;
+	WsTask *t = atomic_load_explicit(&w->buf[top & (DEQUE_SIZE-1)],
+			memory_order_relaxed);
+	if(!atomic_compare_exchange_strong_explicit(&w->top, &top, top+1,
+			memory_order_seq_cst, memory_order_relaxed))
+		return NULL;
+	return t;
+}
+
+static void runTask(Worker *w, WsTask *t){
+	WsGroup *g = t->group;
+	t->f(t->arg);
+	w->tasks++;
+	atomic_fetch_sub_explicit(&g->pending, 1, memory_order_release);
+}
+
+static int stealAndRun(Worker *w){
+	if(numWorkers < 2)
+		return 0;
+	int v = rand_r(&w->seed) % (numWorkers-1);
+	if(v >= myId)
+		v++;
+	w->attempts++;
+	WsTask *t = steal(&workers[v]);
+	if(!t)
+		return 0;
+	w->steals++;
+	runTask(w, t);
+	return 1;
+}
+
+static double now(void){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec*1.0e-9;
+}
+
+static void *workerLoop(void *arg){
+	myId = (long)arg;
+	Worker *w = &workers[myId];
+	for(;;){
+		pthread_mutex_lock(&lock);
+		if(++parked == numWorkers-1)
+			pthread_cond_signal(&allParked);
+		while(!atomic_load(&active) && !atomic_load(&quit))
+			pthread_cond_wait(&wake, &lock);
+		parked--;
+		pthread_mutex_unlock(&lock);
+		if(atomic_load(&quit))
+			return NULL;
+		double idleStart = now();
+		while(atomic_load_explicit(&active, memory_order_acquire)){
+			if(stealAndRun(w)){
+				double t = now();
+				w->idle += t - idleStart;
+				idleStart = t;
+			} else
+				sched_yield();
+		}
+		w->idle += now() - idleStart;
+	}
+}
+
+void wsInit(int nw){
+	if(nw < 1){
+		const char *env = getenv("WS_NUM_WORKERS");
+		nw = env ? strtol(env, NULL, 10) : sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	if(nw < 1)
+		nw = 1;
+	if(nw > MAX_WORKERS)
+		nw = MAX_WORKERS;
+	workers = aligned_alloc(64, nw*sizeof(Worker));
+	if(!workers){
+		fprintf(stderr,"couldn't allocate memory for %d workers\n", nw);
+		exit(1);
+	}
+	memset(workers, 0, nw*sizeof(Worker));
+	numWorkers = nw;
+	myId = 0;
+	atomic_store(&active, 0);
+	atomic_store(&quit, 0);
+	parked = 0;
+	for(int i=0; i<nw; i++)
+		workers[i].seed = i+1;
+	for(long i=1; i<nw; i++)
+		if(pthread_create(&threads[i], NULL, workerLoop, (void *)i)){
+			fprintf(stderr,"couldn't create worker thread\n");
+			exit(1);
+		}
+}
+
+void wsFinalize(void){
+	pthread_mutex_lock(&lock);
+	atomic_store(&quit, 1);
+	pthread_cond_broadcast(&wake);
+	pthread_mutex_unlock(&lock);
+	for(int i=1; i<numWorkers; i++)
+		pthread_join(threads[i], NULL);
+	free(workers);
+	workers = NULL;
+	numWorkers = 0;
+}
+
+int wsNumWorkers(void){
+	return numWorkers;
+}
+
+void wsRun(TaskFunc f, void *arg){
+	pthread_mutex_lock(&lock);
+	atomic_store(&active, 1);
+	pthread_cond_broadcast(&wake);
+	pthread_mutex_unlock(&lock);
+	f(arg);
+	//all tasks spawned by f have been synced, so none left to steal
+	atomic_store(&active, 0);
+	//wait for workers to leave their steal loop, so their statistics
+	//are complete and not being updated when we return
+	pthread_mutex_lock(&lock);
+	while(parked < numWorkers-1)
+		pthread_cond_wait(&allParked, &lock);
+	pthread_mutex_unlock(&lock);
+}
+
+void wsSpawn(WsGroup *g, WsTask *t, TaskFunc f, void *arg){
+	t->f = f;
+	t->arg = arg;
+	t->group = g;
+	atomic_fetch_add_explicit(&g->pending, 1, memory_order_relaxed);
+	Worker *w = &workers[myId];
+	if(!push(w, t))
+		runTask(w, t);
+}
+
+void wsSync(WsGroup *g){
+	Worker *w = &workers[myId];
+	double idleStart = -1;
+	while(atomic_load_explicit(&g->pending, memory_order_acquire) > 0){
+		WsTask *t = take(w);
+		if(t || stealAndRun(w)){
+			if(t)
+				runTask(w, t);
+			if(idleStart >= 0){
+				w->idle += now() - idleStart;
+				idleStart = -1;
+			}
+		} else if(idleStart < 0)
+			idleStart = now();
+		else
+			sched_yield();
+	}
+	if(idleStart >= 0)
+		w->idle += now() - idleStart;
+}
+
+void wsPrintStats(FILE *f){
+	long tasks = 0, steals = 0, attempts = 0;
+	double idle = 0;
+	fprintf(f, "%6s %12s %12s %14s %10s\n", "worker", "tasks", "steals",
+			"steal tries", "idle (s)");
+	for(int i=0; i<numWorkers; i++){
+		Worker *w = &workers[i];
+		fprintf(f, "%6d %12ld %12ld %14ld %10f\n", i, w->tasks, w->steals,
+				w->attempts, w->idle);
+		tasks += w->tasks;
+		steals += w->steals;
+		attempts += w->attempts;
+		idle += w->idle;
+	}
+	fprintf(f, "%6s %12ld %12ld %14ld %10f\n", "total", tasks, steals, attempts,
+			idle);
+}
+
+void wsResetStats(void){
+	for(int i=0; i<numWorkers; i++){
+		workers[i].tasks = workers[i].steals = workers[i].attempts = 0;
+		workers[i].idle = 0;
+	}
+}
@@ -0,0 +1,56 @@
+// Work-stealing fork-join runtime, a portable replacement for the
+// cilk_spawn and cilk_sync of Cilk Plus, used by piForkJoin.c and
+// mergeSortForkJoin.c.
+// Each worker (a thread) has a Chase-Lev deque of tasks. A worker pushes
+// the tasks it spawns onto the bottom of its deque and takes them back
+// from the bottom, while idle workers steal from the top of the deques
+// of randomly chosen workers, so the oldest (usually largest) tasks are
+// stolen. Spawned tasks are described by a WsTask in the frame of the
+// function that spawns them, so no memory is allocated. While waiting at
+// wsSync a worker runs tasks from its deque or steals them.
+// Usage:
+//   wsInit(0);                          //number of workers from WS_NUM_WORKERS
+//   wsRun(root, &args);                 //root(&args) run by workers
+//   wsFinalize();
+// and in root or functions called by it:
+//   WsGroup g = WS_GROUP_INIT;
+//   WsTask t;
+//   wsSpawn(&g, &t, f, &fArgs);         //f(&fArgs) may run in parallel
+//   ...                                 //with this code
+//   wsSync(&g);                         //wait for tasks spawned in g
+#ifndef WORKSTEAL_H
+#define WORKSTEAL_H
+#include <stdio.h>
+#include <stdatomic.h>
+
+typedef void (*TaskFunc)(void *arg);
+// tasks that are waited for together
+typedef struct{
+	atomic_int pending; //spawned tasks not finished
+} WsGroup;
+#define WS_GROUP_INIT {0}
+typedef struct{
+	TaskFunc f;
+	void *arg;
+	WsGroup *group;
+} WsTask;
+
+// starts runtime with nw workers (including the calling thread), or if
+// nw < 1 with WS_NUM_WORKERS workers (number of cores if not set)
+void wsInit(int nw);
+// stops worker threads
+void wsFinalize(void);
+// number of workers
+int wsNumWorkers(void);
+// runs f(arg) in calling thread, with other workers stealing its tasks;
+// returns when all workers have stopped stealing
+void wsRun(TaskFunc f, void *arg);
+// spawns task f(arg) in group g, t must be valid until wsSync(g)
+void wsSpawn(WsGroup *g, WsTask *t, TaskFunc f, void *arg);
+// waits for all tasks spawned in g
+void wsSync(WsGroup *g);
+// writes tasks run, steals, steal attempts and idle time of each worker
+// since wsInit or wsResetStats
+void wsPrintStats(FILE *f);
+void wsResetStats(void);
+#endif
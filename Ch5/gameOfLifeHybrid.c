@@ -0,0 +1,257 @@
+/* Copyright 2017 Eric Aubanel
+ * This file contains code extending Algorithm  5.4 from
+ * Elements of Parallel Computing, by Eric Aubanel, 2016, CRC Press.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------
+ * Hybrid MPI and OpenMP implementation of Conway's Game of Life, with
+ * periodic boundary conditions, and overlap of computation and
+ * communication, based on gameOfLifeMPIPersistent.c.
+ * Each process's block of rows is updated by a team of OpenMP threads.
+ * MPI is initialized with MPI_THREAD_FUNNELED: only the master thread
+ * makes MPI calls. In each generation the master thread starts the
+ * (persistent) exchange of ghost rows, then all threads update the
+ * interior rows, the master thread waits for the exchange to complete,
+ * and all threads update the boundary rows. The parallel region spans
+ * all generations, so threads are only created once.
+ * Use gameOfLifeHybrid.sh to time all combinations of processes and
+ * threads.
+ * Also includes initialization and display of grid.
+ * Assumes number of rows (n) divisible by number of processors (p).
+ * Process 0 has entire grid, plus two ghost rows (first and last).
+ * Other processes have grid with n/p + 2 rows (includes 2 ghost rows).
+ * If DISPLAY defined, displays grid after every DISP_FREQ generations,
+ * otherwise only displays initial and final grids.
+ * Grid diplayed by gathering it from all processes, then 
+ * process 0 writes it to file gameOfLifeMPI.txt.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <omp.h>
+#include "mpi.h"
+
+//update grid, store results in newGrid, for rows start to end, and n columns
+//contains orphaned OpenMP for directive, so is shared by the thread team
+void updateGrid(char **grid, char **newGrid, int start, int end, int m, int n);
+//writes entire grid to file f
+void display(FILE *f, char **grid, int n);
+//called by process 0 to initialize grid with random values
+//using seed for rand(), or time(NULL) if seed is -1
+char **initialize(int seed, int n);
+//allocate char array with m rows and n columns
+char **allocate2D(int m, int n);
+//set up persistent exchange of ghost rows of grid (m rows, n columns)
+//with upper neighbour nbUp and lower neighbour nbDown in req[4]
+void initExchange(char **grid, int m, int n, int nbUp, int nbDown,
+		MPI_Request *req);
+
+#define DISP_FREQ 10
+
+int main(int argc, char **argv){
+	int n; // n x n grid
+	int ngen; // number of generations
+	char **grid; // Game grid
+	char **newGrid; //copy of grid
+	int id; //my id
+	int p; //number of processes
+	FILE *f; //grids written to this file
+	double time;
+
+	MPI_Request req[2][4]; //requests for exchange from grid and newGrid
+	int provided; //thread support provided by MPI library
+	MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+	MPI_Comm_rank(MPI_COMM_WORLD, &id);
+	MPI_Comm_size(MPI_COMM_WORLD, &p);
+	if(provided < MPI_THREAD_FUNNELED){
+		if(!id) fprintf(stderr,"MPI library doesn't support MPI_THREAD_FUNNELED\n");
+		MPI_Finalize();
+		return 1;
+	}
+
+	if(argc <2){
+		if(!id) fprintf(stderr,"usage: %s n [ngen [seed]]\n", argv[0]);
+		MPI_Finalize();
+		return 1;
+	}
+	n = strtol(argv[1], NULL, 10);
+	if(n%p){
+		if(!id) fprintf(stderr,"n must be divisible by number of processes\n");
+		MPI_Finalize();
+		return 1;
+	}
+	int m = n/p; //number of rows per process
+	
+	int seed;
+	if(!id){
+		if(4 == argc)
+			seed = strtol(argv[3], NULL, 10);
+		else
+			seed = -1;
+		grid = initialize(seed, n);
+	} else{
+		 grid = allocate2D(m+2, n);
+	}
+	if(grid == NULL){
+			if(!id) fprintf(stderr,"couldn't allocate memory for grid\n");
+			MPI_Finalize();
+	}
+
+	MPI_Scatter(&grid[1][0], m*n, MPI_CHAR, &grid[1][0], m*n, MPI_CHAR,
+							0, MPI_COMM_WORLD);
+
+	if(!id)
+		newGrid = allocate2D(n+2, n);
+	else
+		newGrid = allocate2D(m+2, n);
+	if(newGrid == NULL){
+		if(!id) fprintf(stderr,"couldn't allocate memory for newGrid\n");
+		MPI_Finalize();
+		return 1;
+	}
+	if(!id){
+		f = fopen("gameOfLifeMPI.txt","w");
+		display(f, grid, n);
+		if(argc > 2)
+			ngen = strtol(argv[2], NULL, 10);
+		else{
+			printf("enter number of generations: ");
+			fflush(stdout);
+			scanf("%d", &ngen);
+		}
+	}
+	MPI_Bcast(&ngen, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+	int nbDown = (id+1)%p; //lower neighbour
+	int nbUp = (id-1+p)%p; //upper neighbour
+	initExchange(grid, m, n, nbUp, nbDown, req[0]);
+	initExchange(newGrid, m, n, nbUp, nbDown, req[1]);
+	MPI_Barrier(MPI_COMM_WORLD);
+	time = -MPI_Wtime();
+	#pragma omp parallel
+	for(int k=0; k<ngen; k++){
+		#pragma omp master
+		MPI_Startall(4, req[k%2]);
+		//interior rows don't need ghost rows, so no barrier
+		updateGrid(grid, newGrid, 2, m-1, m, n);
+		#pragma omp master
+		MPI_Waitall(4, req[k%2], MPI_STATUSES_IGNORE);
+		#pragma omp barrier
+		updateGrid(grid, newGrid, 1, 1, m, n);
+		if(m > 1)
+			updateGrid(grid, newGrid, m, m, m, n);
+		#pragma omp master
+		{
+			char ** temp = grid;
+			grid = newGrid;
+			newGrid = temp;
+			#ifdef DISPLAY
+			if(k % DISP_FREQ == 0){
+				MPI_Gather(&grid[1][0], m*n, MPI_CHAR, &grid[1][0], m*n, MPI_CHAR,
+									0, MPI_COMM_WORLD);
+				if(!id)
+					display(f, grid, n);
+			}
+			#endif
+		}
+		#pragma omp barrier
+	}
+	time += MPI_Wtime();
+	double ptime;
+	MPI_Reduce(&time, &ptime, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+	if(!id)
+		printf("time in seconds, %d processes x %d threads: %f\n\n", p,
+				omp_get_max_threads(), ptime);
+	for(int i=0; i<2; i++)
+		for(int j=0; j<4; j++)
+			MPI_Request_free(&req[i][j]);
+	MPI_Gather(&grid[1][0], m*n, MPI_CHAR, &grid[1][0], m*n, MPI_CHAR,
+						0, MPI_COMM_WORLD);
+	if(!id)
+		display(f, grid, n);
+	MPI_Finalize();
+	return 0;
+}
+
+void initExchange(char **grid, int m, int n, int nbUp, int nbDown,
+		MPI_Request *req){
+	MPI_Send_init(&grid[m][0], n, MPI_CHAR, nbDown, 1, MPI_COMM_WORLD, &req[0]);
+	MPI_Send_init(&grid[1][0], n, MPI_CHAR, nbUp, 2, MPI_COMM_WORLD, &req[1]);
+	MPI_Recv_init(&grid[m+1][0], n, MPI_CHAR, nbDown, 2, MPI_COMM_WORLD, &req[2]);
+	MPI_Recv_init(&grid[0][0], n, MPI_CHAR, nbUp, 1, MPI_COMM_WORLD, &req[3]);
+}
+
+void updateGrid(char **grid, char **newGrid, int start, int end, int m, int n){
+	#pragma omp for collapse(2) schedule(static)
+	for(int i=start; i<=end; i++)
+		for(int j=0; j<n; j++){
+			int up = i-1;
+			int down = i+1;
+			int left = (j-1+n)%n;
+			int right = (j+1)%n;
+			int sumAlive = grid[up][left] + grid[up][j] + grid[up][right] +
+					grid[i][left] + grid[i][right] + 
+					grid[down][left] + grid[down][j] + grid[down][right];
+			if(0 == grid[i][j] && 3 == sumAlive)
+				newGrid[i][j] = 1;
+			else if( 1 == grid[i][j] && (2 == sumAlive || 3 == sumAlive))
+				newGrid[i][j] = 1;
+			else
+				newGrid[i][j] = 0;
+		}
+}
+
+void display(FILE *f, char **grid, int n){
+	for(int i=1; i<=n; i++){
+		for(int j=0; j<n; j++){
+			char alive = 'o';
+			char dead = '.';
+			fprintf(f, "%c",grid[i][j]?alive:dead);
+		}
+		fputc('\n', f);
+	}
+}
+
+char **initialize(int seed, int n){
+	int nrows = 2+n;
+	char *temp = calloc(nrows*n, sizeof(char));
+	char **grid = malloc(nrows*sizeof(char *));
+	if(!temp || !grid)
+		return NULL;
+	if(-1 == seed)
+		srand(time(NULL));
+	else
+		srand(seed);
+	//leave first and last rows blank (ghost rows)
+	for(int i=n; i<(nrows-1)*n; i++)
+		if(rand() > RAND_MAX/2)
+			temp[i] = 1;
+	for(int i=0; i<nrows; i++)
+		grid[i] = temp + i*n;
+	return grid;
+}
+	
+char **allocate2D(int m, int n){
+		char *temp = malloc(m*n*sizeof(char));
+		char **a = malloc(m*sizeof(char *));
+		if(!temp || !a)
+			return NULL;
+		for(int i=0; i<m; i++)
+			a[i] = temp + i*n;
+		return a;
+}
+
+
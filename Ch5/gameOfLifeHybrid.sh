@@ -0,0 +1,47 @@
+#!/bin/sh
+# Times gameOfLifeHybrid.c for every combination of number of MPI
+# processes and OpenMP threads per process (powers of 2) whose product
+# is at most the number of cores, on one machine.
+# usage: gameOfLifeHybrid.sh [n [ngen [cores]]]
+# n must be divisible by the largest number of processes.
+# Set MPIRUN to change how programs are launched; OMP_NUM_THREADS is
+# passed to processes with -x (Open MPI), and processes aren't bound to
+# cores with --bind-to none, since Open MPI binds each process to one
+# core when there are at most 2, so all of its threads would share it.
+
+n=${1:-4096}
+ngen=${2:-100}
+cores=${3:-$(nproc)}
+MPIRUN=${MPIRUN:-mpirun}
+dir=$(dirname "$0")
+
+mpicc -fopenmp -O2 -std=gnu99 -o gameOfLifeHybrid "$dir/gameOfLifeHybrid.c" ||
+		exit 1
+
+echo "time in s, n=$n, $ngen generations"
+printf "%10s" "p \\ t"
+t=1
+while [ $t -le "$cores" ]; do
+	printf " %10d" $t
+	t=$((t*2))
+done
+echo
+p=1
+while [ $p -le "$cores" ]; do
+	printf "%10d" $p
+	t=1
+	while [ $t -le "$cores" ]; do
+		if [ $((p*t)) -le "$cores" ]; then
+			time=$(OMP_NUM_THREADS=$t $MPIRUN -x OMP_NUM_THREADS --bind-to none \
+					-np $p ./gameOfLifeHybrid "$n" "$ngen" 1 |
+					sed -n 's/.*threads: //p')
+			printf " %10s" "$time"
+		else
+			printf " %10s" "-"
+		fi
+		t=$((t*2))
+	done
+	echo
+	p=$((p*2))
+done
+rm -f gameOfLifeMPI.txt
@@ -0,0 +1,263 @@
+/* Copyright 2017 Eric Aubanel
+ * This file contains code extending Algorithm  4.16 from
+ * Elements of Parallel Computing, by Eric Aubanel, 2016, CRC Press.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------
+ * Parallel MPI implementation of Conway's Game of Life, with periodic
+ * boundary conditions, using a 2D block decomposition.
+ * Processes form a periodic 2D Cartesian grid (MPI_Cart_create), with
+ * dimensions chosen by MPI_Dims_create, or p x 1 if "rows" is given,
+ * which gives the row decomposition of gameOfLifeMPI.c.
+ * n need not be divisible by the process grid dimensions: process
+ * (r,c) of a q0 x q1 grid has rows [r*n/q0 .. (r+1)*n/q0) and columns
+ * [c*n/q1 .. (c+1)*n/q1), plus a layer of ghost cells all round.
+ * Ghost cells are exchanged in two phases: first columns, using a
+ * vector datatype, with the left and right neighbours; then whole
+ * rows, including the ghost columns, with the upper and lower
+ * neighbours. The second phase carries the corner cells, so no
+ * messages to diagonal neighbours are needed.
+ * Each process initializes its own block; cell (i,j) is a hash of
+ * (seed, i, j), so the grid doesn't depend on the number of processes.
+ * For n <= VERIFY_MAX, blocks are gathered to process 0 using a
+ * subarray datatype and checked against a sequential run.
+ * See gameOfLifeScaling.sh for a strong/weak scaling comparison of the
+ * 2D and row decompositions.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "mpi.h"
+
+#define VERIFY_MAX 2048
+
+//update interior of grid with m rows and w columns plus ghost cells,
+//store results in newGrid
+void updateGrid(char **grid, char **newGrid, int m, int w);
+//exchange ghost cells with neighbours in Cartesian communicator comm
+void exchange(char **grid, int m, int w, MPI_Datatype colType, MPI_Comm comm);
+//initial value of cell (i,j)
+char initialCell(unsigned long long seed, long i, long j, long n);
+//allocate char array with m rows and n columns
+char **allocate2D(int m, int n);
+//sequential run of ngen generations, for verification
+char **sequentialLife(unsigned long long seed, int n, int ngen);
+
+int main(int argc, char **argv){
+	int n; // n x n grid
+	int ngen; // number of generations
+	char **grid; // Game grid
+	char **newGrid; //copy of grid
+	int id; //my id
+	int p; //number of processes
+	double time;
+
+	MPI_Init(&argc, &argv);
+	MPI_Comm_rank(MPI_COMM_WORLD, &id);
+	MPI_Comm_size(MPI_COMM_WORLD, &p);
+
+	if(argc <3){
+		if(!id) fprintf(stderr,"usage: %s n ngen [seed] [rows]\n", argv[0]);
+		MPI_Finalize();
+		return 1;
+	}
+	n = strtol(argv[1], NULL, 10);
+	ngen = strtol(argv[2], NULL, 10);
+	unsigned long long seed = 1;
+	if(argc > 3)
+		seed = strtoull(argv[3], NULL, 10);
+	int dims[2] = {0, 0};
+	if(argc > 4 && !strcmp(argv[4], "rows")){
+		dims[0] = p;
+		dims[1] = 1;
+	}
+	MPI_Dims_create(p, 2, dims);
+	if(n < dims[0] || n < dims[1]){
+		if(!id) fprintf(stderr,"n must be at least %d\n",
+				dims[0] > dims[1] ? dims[0] : dims[1]);
+		MPI_Finalize();
+		return 1;
+	}
+	int periods[2] = {1, 1};
+	MPI_Comm comm;
+	MPI_Cart_create(MPI_COMM_WORLD, 2, dims, periods, 1, &comm);
+	MPI_Comm_rank(comm, &id);
+	int coords[2];
+	MPI_Cart_coords(comm, id, 2, coords);
+	//my block: rows [i0..i0+m), columns [j0..j0+w)
+	int i0 = (long)coords[0]*n/dims[0];
+	int m = (long)(coords[0]+1)*n/dims[0] - i0;
+	int j0 = (long)coords[1]*n/dims[1];
+	int w = (long)(coords[1]+1)*n/dims[1] - j0;
+
+	grid = allocate2D(m+2, w+2);
+	newGrid = allocate2D(m+2, w+2);
+	if(!grid || !newGrid){
+		fprintf(stderr,"couldn't allocate memory for grid\n");
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+	for(int i=1; i<=m; i++)
+		for(int j=1; j<=w; j++)
+			grid[i][j] = initialCell(seed, i0+i-1, j0+j-1, n);
+
+	//one interior column of the block
+	MPI_Datatype colType;
+	MPI_Type_vector(m, 1, w+2, MPI_CHAR, &colType);
+	MPI_Type_commit(&colType);
+
+	MPI_Barrier(comm);
+	time = -MPI_Wtime();
+	for(int k=0; k<ngen; k++){
+		exchange(grid, m, w, colType, comm);
+		updateGrid(grid, newGrid, m, w);
+		char ** temp = grid;
+		grid = newGrid;
+		newGrid = temp;
+	}
+	time += MPI_Wtime();
+	double ptime;
+	MPI_Reduce(&time, &ptime, 1, MPI_DOUBLE, MPI_MAX, 0, comm);
+	if(!id){
+		printf("%d x %d processes, time in seconds: %f\n", dims[0], dims[1],
+				ptime);
+		printf("cell updates/s: %e\n", (double)n*n*ngen/ptime);
+	}
+
+	if(n <= VERIFY_MAX){
+		//interior of my block, sent to process 0
+		MPI_Datatype blockType;
+		int sizes[2] = {m+2, w+2}, subsizes[2] = {m, w}, starts[2] = {1, 1};
+		MPI_Type_create_subarray(2, sizes, subsizes, starts, MPI_ORDER_C,
+				MPI_CHAR, &blockType);
+		MPI_Type_commit(&blockType);
+		MPI_Request req;
+		MPI_Isend(&grid[0][0], 1, blockType, 0, 0, comm, &req);
+		if(!id){
+			char **result = allocate2D(n, n);
+			char **ref = sequentialLife(seed, n, ngen);
+			if(!result || !ref){
+				fprintf(stderr,"couldn't allocate memory for verification\n");
+				MPI_Abort(MPI_COMM_WORLD, 1);
+			}
+			for(int r=0; r<p; r++){
+				int c[2];
+				MPI_Cart_coords(comm, r, 2, c);
+				int ri0 = (long)c[0]*n/dims[0];
+				int rj0 = (long)c[1]*n/dims[1];
+				int gsizes[2] = {n, n}, gstarts[2] = {ri0, rj0};
+				int rsub[2] = {(long)(c[0]+1)*n/dims[0] - ri0,
+						(long)(c[1]+1)*n/dims[1] - rj0};
+				MPI_Datatype recvType;
+				MPI_Type_create_subarray(2, gsizes, rsub, gstarts, MPI_ORDER_C,
+						MPI_CHAR, &recvType);
+				MPI_Type_commit(&recvType);
+				MPI_Recv(&result[0][0], 1, recvType, r, 0, comm, MPI_STATUS_IGNORE);
+				MPI_Type_free(&recvType);
+			}
+			if(memcmp(result[0], ref[0], (size_t)n*n))
+				printf("result differs from sequential version\n");
+			else
+				printf("result verified\n");
+		}
+		MPI_Wait(&req, MPI_STATUS_IGNORE);
+		MPI_Type_free(&blockType);
+	}
+	MPI_Type_free(&colType);
+	MPI_Finalize();
+	return 0;
+}
+
+void exchange(char **grid, int m, int w, MPI_Datatype colType, MPI_Comm comm){
+	int left, right, up, down;
+	MPI_Cart_shift(comm, 1, 1, &left, &right);
+	MPI_Cart_shift(comm, 0, 1, &up, &down);
+	//columns
+	MPI_Sendrecv(&grid[1][1], 1, colType, left, 1,
+			&grid[1][w+1], 1, colType, right, 1, comm, MPI_STATUS_IGNORE);
+	MPI_Sendrecv(&grid[1][w], 1, colType, right, 2,
+			&grid[1][0], 1, colType, left, 2, comm, MPI_STATUS_IGNORE);
+	//rows, including ghost columns, which brings corners
+	MPI_Sendrecv(&grid[1][0], w+2, MPI_CHAR, up, 3,
+			&grid[m+1][0], w+2, MPI_CHAR, down, 3, comm, MPI_STATUS_IGNORE);
+	MPI_Sendrecv(&grid[m][0], w+2, MPI_CHAR, down, 4,
+			&grid[0][0], w+2, MPI_CHAR, up, 4, comm, MPI_STATUS_IGNORE);
+}
+
+void updateGrid(char **grid, char **newGrid, int m, int w){
+	for(int i=1; i<=m; i++)
+		for(int j=1; j<=w; j++){
+			int up = i-1;
+			int down = i+1;
+			int left = j-1;
+			int right = j+1;
+			int sumAlive = grid[up][left] + grid[up][j] + grid[up][right] +
+					grid[i][left] + grid[i][right] +
+					grid[down][left] + grid[down][j] + grid[down][right];
+			if(0 == grid[i][j] && 3 == sumAlive)
+				newGrid[i][j] = 1;
+			else if( 1 == grid[i][j] && (2 == sumAlive || 3 == sumAlive))
+				newGrid[i][j] = 1;
+			else
+				newGrid[i][j] = 0;
+		}
+}
+
+char initialCell(unsigned long long seed, long i, long j, long n){
+	//splitmix64 hash of cell index
+	uint64_t z = seed*0x9E3779B97F4A7C15ULL + (uint64_t)i*n + j;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	z ^= z >> 31;
+	return z >> 63;
+}
+
+char **sequentialLife(unsigned long long seed, int n, int ngen){
+	char **grid = allocate2D(n, n);
+	char **newGrid = allocate2D(n, n);
+	if(!grid || !newGrid)
+		return NULL;
+	for(int i=0; i<n; i++)
+		for(int j=0; j<n; j++)
+			grid[i][j] = initialCell(seed, i, j, n);
+	for(int k=0; k<ngen; k++){
+		for(int i=0; i<n; i++)
+			for(int j=0; j<n; j++){
+				int up = (i-1+n)%n;
+				int down = (i+1)%n;
+				int left = (j-1+n)%n;
+				int right = (j+1)%n;
+				int sumAlive = grid[up][left] + grid[up][j] + grid[up][right] +
+						grid[i][left] + grid[i][right] +
+						grid[down][left] + grid[down][j] + grid[down][right];
+				newGrid[i][j] = (3 == sumAlive) || (2 == sumAlive && grid[i][j]);
+			}
+		char ** temp = grid;
+		grid = newGrid;
+		newGrid = temp;
+	}
+	return grid;
+}
+
+char **allocate2D(int m, int n){
+		char *temp = malloc((size_t)m*n*sizeof(char));
+		char **a = malloc(m*sizeof(char *));
+		if(!temp || !a)
+			return NULL;
+		for(int i=0; i<m; i++)
+			a[i] = temp + (size_t)i*n;
+		return a;
+}
@@ -0,0 +1,315 @@
+/* Copyright 2017 Eric Aubanel
+ * This file contains code extending Algorithm  5.3 from
+ * Elements of Parallel Computing, by Eric Aubanel, 2016, CRC Press.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------
+ * Parallel MPI implementation of Conway's Game of Life, with periodic
+ * boundary conditions, and k layers of ghost cells, generalizing
+ * gameOfLifeMPIV2.c (k = 2).
+ * k ghost rows are exchanged with each neighbour every k generations.
+ * In between, ghost rows are updated redundantly: after s generations
+ * without an exchange, only the k-1-s ghost rows nearest the block are
+ * updated, so k times fewer messages are sent at the cost of computing
+ * (k-1) extra rows per generation on average.
+ * If k is 0, it is chosen using a simple model. Latency a and inverse
+ * bandwidth b are measured by ping-pong between processes 0 and 1, and
+ * time per cell update c by timing updateGrid. The time per generation
+ * is then about 2a/k + 2bn + cn(m + k - 1), for m = n/p rows per
+ * process, which is smallest for k = sqrt(2a/(cn)).
+ * Also includes initialization and display of grid.
+ * Assumes number of rows (n) divisible by number of processors (p),
+ * and n/p >= k.
+ * Process 0 has entire grid, plus 2k ghost rows (first and last k).
+ * Other processes have grid with n/p + 2k rows (includes 2k ghost rows).
+ * If DISPLAY defined, displays grid after every DISP_FREQ generations,
+ * otherwise only displays initial and final grids.
+ * Grid diplayed by gathering it from all processes, then
+ * process 0 writes it to file gameOfLifeMPI.txt.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "mpi.h"
+
+//update grid, store results in newGrid, for rows start to end
+//and n columns
+void updateGrid(char **grid, char **newGrid, int start, int end, int n);
+//writes entire grid (rows k to n+k-1) to file f
+void display(FILE *f, char **grid, int n, int k);
+//called by process 0 to initialize grid with random values
+//using seed for rand(), or time(NULL) if seed is -1
+char **initialize(int seed, int n, int k);
+//allocate char array with m rows and n columns
+char **allocate2D(int m, int n);
+//measure latency (s) and inverse bandwidth (s/byte) between processes
+//0 and 1 by ping-pong with messages of 1 and len bytes
+void pingPong(int id, int len, double *latency, double *invBandwidth);
+//predicted best halo depth for latency a, inverse bandwidth b,
+//time per cell update c, m rows and n columns per process
+int bestDepth(double a, double b, double c, int m, int n);
+
+#define DISP_FREQ 10
+#define REPS 100 //ping-pong repetitions
+
+int main(int argc, char **argv){
+	int n; // n x n grid
+	int ngen; // number of generations
+	int k; // number of ghost rows
+	char **grid; // Game grid
+	char **newGrid; //copy of grid
+	int id; //my id
+	int p; //number of processes
+	FILE *f; //grids written to this file
+	double time;
+
+	MPI_Status status;
+  MPI_Request req_send_up, req_send_down;
+	MPI_Init(&argc, &argv);
+	MPI_Comm_rank(MPI_COMM_WORLD, &id);
+	MPI_Comm_size(MPI_COMM_WORLD, &p);
+
+	if(argc <4){
+		if(!id) fprintf(stderr,"usage: %s n ngen k [seed]\n", argv[0]);
+		if(!id) fprintf(stderr,"k = 0 chooses k from a performance model\n");
+		MPI_Finalize();
+		return 1;
+	}
+	n = strtol(argv[1], NULL, 10);
+	ngen = strtol(argv[2], NULL, 10);
+	k = strtol(argv[3], NULL, 10);
+	if(n%p){
+		if(!id) fprintf(stderr,"n must be divisible by number of processes\n");
+		MPI_Finalize();
+		return 1;
+	}
+	int m = n/p; //number of rows per process
+
+	if(k == 0){
+		//time per cell update, from one generation of 2 rows
+		char **a = allocate2D(4, n), **b = allocate2D(4, n);
+		if(!a || !b){
+			if(!id) fprintf(stderr,"couldn't allocate memory\n");
+			MPI_Finalize();
+			return 1;
+		}
+		for(int i=0; i<4*n; i++)
+			a[0][i] = rand() > RAND_MAX/2;
+		double c = MPI_Wtime();
+		for(int r=0; r<REPS; r++)
+			updateGrid(a, b, 1, 2, n);
+		c = (MPI_Wtime() - c)/(2.0*n*REPS);
+		MPI_Bcast(&c, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+		free(a[0]); free(a); free(b[0]); free(b);
+		double latency = 0.0, invBandwidth = 0.0;
+		if(p > 1)
+			pingPong(id, m*n, &latency, &invBandwidth);
+		k = bestDepth(latency, invBandwidth, c, m, n);
+		if(!id){
+			printf("latency %g s, bandwidth %g bytes/s, cell update %g s\n",
+					latency, invBandwidth > 0 ? 1/invBandwidth : 0.0, c);
+			printf("predicted best k = %d\n", k);
+		}
+	}
+	if(k < 1 || k > m){
+		if(!id) fprintf(stderr,"k must be between 1 and n/p\n");
+		MPI_Finalize();
+		return 1;
+	}
+
+	int seed;
+	if(!id){
+		if(5 == argc)
+			seed = strtol(argv[4], NULL, 10);
+		else
+			seed = -1;
+		grid = initialize(seed, n, k);
+	} else{
+			grid = allocate2D(m+2*k, n);
+	}
+	if(grid == NULL){
+			if(!id) fprintf(stderr,"couldn't allocate memory for grid\n");
+			MPI_Finalize();
+			return 1;
+	}
+
+	MPI_Scatter(&grid[k][0], m*n, MPI_CHAR, &grid[k][0], m*n, MPI_CHAR,
+							0, MPI_COMM_WORLD);
+
+	if(!id)
+		newGrid = allocate2D(n+2*k, n);
+	else
+		newGrid = allocate2D(m+2*k, n);
+	if(newGrid == NULL){
+		if(!id) fprintf(stderr,"couldn't allocate memory for newGrid\n");
+		MPI_Finalize();
+		return 1;
+	}
+	if(!id){
+		f = fopen("gameOfLifeMPI.txt","w");
+		display(f, grid, n, k);
+	}
+
+	int nbDown = (id+1)%p; //lower neighbour
+	int nbUp = (id-1+p)%p; //upper neighbour
+	MPI_Barrier(MPI_COMM_WORLD);
+	time = -MPI_Wtime();
+	for(int gen=0; gen<ngen; gen++){
+		int offset = gen%k; //generations since last exchange
+		if(!offset){
+			//exhange boundary values
+			MPI_Isend(&grid[m][0], k*n, MPI_CHAR, nbDown, 1,
+							MPI_COMM_WORLD, &req_send_down);
+			MPI_Isend(&grid[k][0], k*n, MPI_CHAR, nbUp, 2,
+							MPI_COMM_WORLD, &req_send_up);
+			MPI_Recv(&grid[m+k][0], k*n, MPI_CHAR, nbDown, 2,
+							MPI_COMM_WORLD, &status);
+			MPI_Recv(&grid[0][0], k*n, MPI_CHAR, nbUp, 1,
+							MPI_COMM_WORLD, &status);
+			MPI_Wait(&req_send_down, &status);
+			MPI_Wait(&req_send_up, &status);
+		}
+		updateGrid(grid, newGrid, 1+offset, m+2*k-2-offset, n);
+		char ** temp = grid;
+		grid = newGrid;
+		newGrid = temp;
+
+		#ifdef DISPLAY
+		if(gen % DISP_FREQ == 0){
+			MPI_Gather(&grid[k][0], m*n, MPI_CHAR, &grid[k][0], m*n, MPI_CHAR,
+								0, MPI_COMM_WORLD);
+			if(!id)
+				display(f, grid, n, k);
+		}
+		#endif
+	}
+	time += MPI_Wtime();
+	double ptime;
+	MPI_Reduce(&time, &ptime, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+	if(!id)
+		printf("k = %d, time in seconds: %f\n\n", k, ptime);
+	MPI_Gather(&grid[k][0], m*n, MPI_CHAR, &grid[k][0], m*n, MPI_CHAR,
+						0, MPI_COMM_WORLD);
+	if(!id)
+		display(f, grid, n, k);
+	MPI_Finalize();
+	return 0;
+}
+
+void pingPong(int id, int len, double *latency, double *invBandwidth){
+	char *buf = calloc(len, 1);
+	double t[2];
+	int size[2] = {1, len};
+	if(!buf){
+		fprintf(stderr,"couldn't allocate memory for ping-pong\n");
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+	for(int s=0; s<2; s++){
+		MPI_Barrier(MPI_COMM_WORLD);
+		t[s] = MPI_Wtime();
+		for(int r=0; r<REPS && id < 2; r++)
+			if(!id){
+				MPI_Send(buf, size[s], MPI_CHAR, 1, 0, MPI_COMM_WORLD);
+				MPI_Recv(buf, size[s], MPI_CHAR, 1, 0, MPI_COMM_WORLD,
+						MPI_STATUS_IGNORE);
+			} else{
+				MPI_Recv(buf, size[s], MPI_CHAR, 0, 0, MPI_COMM_WORLD,
+						MPI_STATUS_IGNORE);
+				MPI_Send(buf, size[s], MPI_CHAR, 0, 0, MPI_COMM_WORLD);
+			}
+		t[s] = (MPI_Wtime() - t[s])/(2*REPS); //one-way time
+	}
+	*latency = t[0];
+	*invBandwidth = len > 1 ? (t[1] - t[0])/(len - 1) : 0.0;
+	if(*invBandwidth < 0)
+		*invBandwidth = 0.0;
+	MPI_Bcast(latency, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+	MPI_Bcast(invBandwidth, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+	free(buf);
+}
+
+int bestDepth(double a, double b, double c, int m, int n){
+	//time per generation for depth k, in the model
+	#define MODEL(k) (2*a/(k) + 2*b*n + c*n*(m + (k) - 1))
+	int k = (int)sqrt(2*a/(c*n));
+	if(k < 1)
+		k = 1;
+	//sqrt gives real optimum, so check neighbouring integer
+	if(MODEL(k+1) < MODEL(k))
+		k++;
+	#undef MODEL
+	return k > m ? m : k;
+}
+
+void updateGrid(char **grid, char **newGrid, int start, int end, int n){
+	for(int i=start; i<=end; i++)
+		for(int j=0; j<n; j++){
+			int up = i-1;
+			int down = i+1;
+			int left = (j-1+n)%n;
+			int right = (j+1)%n;
+			int sumAlive = grid[up][left] + grid[up][j] + grid[up][right] +
+					grid[i][left] + grid[i][right] +
+					grid[down][left] + grid[down][j] + grid[down][right];
+			if(0 == grid[i][j] && 3 == sumAlive)
+				newGrid[i][j] = 1;
+			else if( 1 == grid[i][j] && (2 == sumAlive || 3 == sumAlive))
+				newGrid[i][j] = 1;
+			else
+				newGrid[i][j] = 0;
+		}
+}
+
+void display(FILE *f, char **grid, int n, int k){
+	for(int i=k; i<n+k; i++){
+		for(int j=0; j<n; j++){
+			char alive = 'o';
+			char dead = '.';
+			fprintf(f, "%c",grid[i][j]?alive:dead);
+		}
+		fputc('\n', f);
+	}
+}
+
+char **initialize(int seed, int n, int k){
+	int nrows = 2*k+n;
+	char *temp = calloc(nrows*n, sizeof(char));
+	char **grid = malloc(nrows*sizeof(char *));
+	if(!temp || !grid)
+		return NULL;
+	if(-1 == seed)
+		srand(time(NULL));
+	else
+		srand(seed);
+	//leave first and last k rows blank (ghost rows)
+	for(int i=k*n; i<(n+k)*n; i++)
+		if(rand() > RAND_MAX/2)
+			temp[i] = 1;
+	for(int i=0; i<nrows; i++)
+		grid[i] = temp + i*n;
+	return grid;
+}
+
+char **allocate2D(int m, int n){
+		char *temp = malloc(m*n*sizeof(char));
+		char **a = malloc(m*sizeof(char *));
+		if(!temp || !a)
+			return NULL;
+		for(int i=0; i<m; i++)
+			a[i] = temp + i*n;
+		return a;
+}
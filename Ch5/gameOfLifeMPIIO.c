@@ -0,0 +1,344 @@
+/* Copyright 2017 Eric Aubanel
+ * This file contains code extending Algorithm  4.16 from
+ * Elements of Parallel Computing, by Eric Aubanel, 2016, CRC Press.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------
+ * Parallel MPI implementation of Conway's Game of Life, with periodic
+ * boundary conditions, and parallel I/O of snapshots.
+ * Instead of gathering the grid to process 0, as display does in
+ * gameOfLifeMPI.c, every process writes its block of rows directly into
+ * a shared binary file using collective MPI-IO. A snapshot is written
+ * every freq generations (and after the last one) to outFile.gen.
+ * A snapshot can be used as a checkpoint: with -r the grid is read in
+ * parallel from a snapshot file, each process reading only its own rows,
+ * and the run continues from the generation stored in the file.
+ * File format: a header of 4 ints (magic number, n, generation, packed)
+ * followed by n rows, of n bytes (one per cell), or if packed (-b) of
+ * (n+7)/8 bytes, with cell j of a row in bit j%8 of byte j/8.
+ * Process k has rows [k*n/p .. (k+1)*n/p), so n need not be divisible by
+ * p, plus 2 ghost rows. The initial grid is a hash of (seed, i, j), so
+ * it doesn't depend on p. For n <= VERIFY_MAX and no restart, process 0
+ * reads the last snapshot with stdio and checks it against a sequential
+ * run.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "mpi.h"
+
+#define VERIFY_MAX 2048
+#define MAGIC 0x314C4F47 // "GOL1"
+#define HEADER (4*sizeof(int))
+
+//update grid, store results in newGrid, for m rows and n columns
+void updateGrid(char **grid, char **newGrid, int m, int n);
+//write snapshot of grid (rows [i0..i0+m) of n x n grid) at generation gen
+//to file name, collectively; returns bytes written by all processes
+double writeSnapshot(const char *name, char **grid, int i0, int m, int n,
+		int gen, int packed, MPI_Comm comm);
+//read n, generation and packed from header of file name, collectively
+void readHeader(const char *name, int *n, int *gen, int *packed, MPI_Comm comm);
+//read rows [i0..i0+m) of grid in snapshot file name, collectively
+void readSnapshot(const char *name, char **grid, int i0, int m, int n,
+		int packed, MPI_Comm comm);
+//initial value of cell (i,j)
+char initialCell(unsigned long long seed, long i, long j, long n);
+//allocate char array with m rows and n columns
+char **allocate2D(int m, int n);
+//sequential run from generation 0 to ngen, for verification
+char **sequentialLife(unsigned long long seed, int n, int ngen);
+
+int main(int argc, char **argv){
+	int n = 0; // n x n grid
+	int ngen; // number of generations
+	int freq; // snapshot frequency
+	char **grid; // Game grid
+	char **newGrid; //copy of grid
+	int id; //my id
+	int p; //number of processes
+	double time, iotime = 0.0, iobytes = 0.0;
+	unsigned long long seed = 1;
+	char *restart = NULL; //checkpoint file
+	int packed = 0;
+
+	MPI_Init(&argc, &argv);
+	MPI_Comm_rank(MPI_COMM_WORLD, &id);
+	MPI_Comm_size(MPI_COMM_WORLD, &p);
+
+	if(argc < 4){
+		if(!id){
+			fprintf(stderr,"usage: %s ngen freq outFile [-n n] [-s seed] "
+					"[-r restartFile] [-b]\n", argv[0]);
+			fprintf(stderr,"-b writes packed snapshots\n");
+		}
+		MPI_Finalize();
+		return 1;
+	}
+	ngen = strtol(argv[1], NULL, 10);
+	freq = strtol(argv[2], NULL, 10);
+	char *outFile = argv[3];
+	for(int i=4; i<argc; i++){
+		if(!strcmp(argv[i], "-b"))
+			packed = 1;
+		else if(i+1 < argc && !strcmp(argv[i], "-n"))
+			n = strtol(argv[++i], NULL, 10);
+		else if(i+1 < argc && !strcmp(argv[i], "-s"))
+			seed = strtoull(argv[++i], NULL, 10);
+		else if(i+1 < argc && !strcmp(argv[i], "-r"))
+			restart = argv[++i];
+		else{
+			if(!id) fprintf(stderr,"unknown option %s\n", argv[i]);
+			MPI_Finalize();
+			return 1;
+		}
+	}
+	int gen0 = 0, packedIn = 0;
+	if(restart)
+		readHeader(restart, &n, &gen0, &packedIn, MPI_COMM_WORLD);
+	if(n < p){
+		if(!id) fprintf(stderr,"n must be given, and at least p\n");
+		MPI_Finalize();
+		return 1;
+	}
+	int i0 = (long)id*n/p; //first row
+	int m = (long)(id+1)*n/p - i0; //number of rows
+	grid = allocate2D(m+2, n);
+	newGrid = allocate2D(m+2, n);
+	if(!grid || !newGrid){
+		fprintf(stderr,"couldn't allocate memory for grid\n");
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+	if(restart){
+		double t = MPI_Wtime();
+		readSnapshot(restart, grid, i0, m, n, packedIn, MPI_COMM_WORLD);
+		t = MPI_Wtime() - t;
+		if(!id)
+			printf("read %s (generation %d) in %f s\n", restart, gen0, t);
+	} else
+		for(int i=1; i<=m; i++)
+			for(int j=0; j<n; j++)
+				grid[i][j] = initialCell(seed, i0+i-1, j, n);
+
+	int nbDown = (id+1)%p; //lower neighbour
+	int nbUp = (id-1+p)%p; //upper neighbour
+	char name[FILENAME_MAX];
+	MPI_Barrier(MPI_COMM_WORLD);
+	time = -MPI_Wtime();
+	for(int k=1; k<=ngen; k++){
+		//exhange boundary values
+		MPI_Sendrecv(&grid[m][0], n, MPI_CHAR, nbDown, 1,
+				&grid[0][0], n, MPI_CHAR, nbUp, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+		MPI_Sendrecv(&grid[1][0], n, MPI_CHAR, nbUp, 2,
+				&grid[m+1][0], n, MPI_CHAR, nbDown, 2, MPI_COMM_WORLD,
+				MPI_STATUS_IGNORE);
+
+		updateGrid(grid, newGrid, m, n);
+		char ** temp = grid;
+		grid = newGrid;
+		newGrid = temp;
+
+		if((freq > 0 && k % freq == 0) || k == ngen){
+			snprintf(name, FILENAME_MAX, "%s.%d", outFile, gen0+k);
+			double t = MPI_Wtime();
+			iobytes += writeSnapshot(name, grid, i0, m, n, gen0+k, packed,
+					MPI_COMM_WORLD);
+			iotime += MPI_Wtime() - t;
+		}
+	}
+	time += MPI_Wtime();
+	double ptime[2], t[2] = {time, iotime};
+	MPI_Reduce(t, ptime, 2, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+	if(!id){
+		printf("time in seconds: %f\n", ptime[0]);
+		printf("snapshot time in seconds: %f (%e bytes/s)\n", ptime[1],
+				ptime[1] > 0 ? iobytes/ptime[1] : 0.0);
+	}
+
+	if(!id && !restart && n <= VERIFY_MAX && ngen > 0){
+		char **ref = sequentialLife(seed, n, ngen);
+		int rowBytes = packed ? (n+7)/8 : n;
+		unsigned char *row = malloc(rowBytes);
+		FILE *f = fopen(name, "rb");
+		int header[4];
+		int passed = ref && row && f && fread(header, sizeof(int), 4, f) == 4 &&
+				header[0] == MAGIC && header[1] == n && header[2] == ngen;
+		for(int i=0; passed && i<n; i++){
+			if(fread(row, 1, rowBytes, f) != (size_t)rowBytes)
+				passed = 0;
+			for(int j=0; passed && j<n; j++){
+				int cell = packed ? (row[j/8] >> j%8) & 1 : row[j];
+				if(cell != ref[i][j])
+					passed = 0;
+			}
+		}
+		if(f)
+			fclose(f);
+		if(passed)
+			printf("result verified\n");
+		else
+			printf("snapshot %s differs from sequential version\n", name);
+	}
+	MPI_Finalize();
+	return 0;
+}
+
+double writeSnapshot(const char *name, char **grid, int i0, int m, int n,
+		int gen, int packed, MPI_Comm comm){
+	MPI_File fh;
+	int id;
+	MPI_Comm_rank(comm, &id);
+	int rowBytes = packed ? (n+7)/8 : n;
+	if(MPI_File_open(comm, name, MPI_MODE_CREATE | MPI_MODE_WRONLY,
+				MPI_INFO_NULL, &fh) != MPI_SUCCESS){
+		if(!id) fprintf(stderr,"can't open file %s\n", name);
+		MPI_Abort(comm, 1);
+	}
+	//truncate any previous, larger, file
+	MPI_File_set_size(fh, HEADER + (MPI_Offset)n*rowBytes);
+	if(!id){
+		int header[4] = {MAGIC, n, gen, packed};
+		MPI_File_write_at(fh, 0, header, 4, MPI_INT, MPI_STATUS_IGNORE);
+	}
+	MPI_Offset offset = HEADER + (MPI_Offset)i0*rowBytes;
+	if(packed){
+		unsigned char *buf = calloc((size_t)m*rowBytes, 1);
+		if(!buf){
+			fprintf(stderr,"couldn't allocate memory for snapshot\n");
+			MPI_Abort(comm, 1);
+		}
+		for(int i=0; i<m; i++)
+			for(int j=0; j<n; j++)
+				if(grid[i+1][j])
+					buf[(size_t)i*rowBytes + j/8] |= 1 << j%8;
+		MPI_File_write_at_all(fh, offset, buf, m*rowBytes, MPI_BYTE,
+				MPI_STATUS_IGNORE);
+		free(buf);
+	} else
+		MPI_File_write_at_all(fh, offset, &grid[1][0], m*n, MPI_BYTE,
+				MPI_STATUS_IGNORE);
+	MPI_File_close(&fh);
+	return HEADER + (double)n*rowBytes;
+}
+
+void readHeader(const char *name, int *n, int *gen, int *packed, MPI_Comm comm){
+	MPI_File fh;
+	int header[4];
+	if(MPI_File_open(comm, name, MPI_MODE_RDONLY, MPI_INFO_NULL, &fh)
+			!= MPI_SUCCESS){
+		fprintf(stderr,"can't open file %s\n", name);
+		MPI_Abort(comm, 1);
+	}
+	MPI_File_read_at_all(fh, 0, header, 4, MPI_INT, MPI_STATUS_IGNORE);
+	MPI_File_close(&fh);
+	if(header[0] != MAGIC){
+		fprintf(stderr,"%s is not a snapshot file\n", name);
+		MPI_Abort(comm, 1);
+	}
+	*n = header[1];
+	*gen = header[2];
+	*packed = header[3];
+}
+
+void readSnapshot(const char *name, char **grid, int i0, int m, int n,
+		int packed, MPI_Comm comm){
+	MPI_File fh;
+	int rowBytes = packed ? (n+7)/8 : n;
+	MPI_File_open(comm, name, MPI_MODE_RDONLY, MPI_INFO_NULL, &fh);
+	MPI_Offset offset = HEADER + (MPI_Offset)i0*rowBytes;
+	if(packed){
+		unsigned char *buf = malloc((size_t)m*rowBytes);
+		if(!buf){
+			fprintf(stderr,"couldn't allocate memory for snapshot\n");
+			MPI_Abort(comm, 1);
+		}
+		MPI_File_read_at_all(fh, offset, buf, m*rowBytes, MPI_BYTE,
+				MPI_STATUS_IGNORE);
+		for(int i=0; i<m; i++)
+			for(int j=0; j<n; j++)
+				grid[i+1][j] = (buf[(size_t)i*rowBytes + j/8] >> j%8) & 1;
+		free(buf);
+	} else
+		MPI_File_read_at_all(fh, offset, &grid[1][0], m*n, MPI_BYTE,
+				MPI_STATUS_IGNORE);
+	MPI_File_close(&fh);
+}
+
+void updateGrid(char **grid, char **newGrid, int m, int n){
+	for(int i=1; i<=m; i++)
+		for(int j=0; j<n; j++){
+			int up = i-1;
+			int down = i+1;
+			int left = (j-1+n)%n;
+			int right = (j+1)%n;
+			int sumAlive = grid[up][left] + grid[up][j] + grid[up][right] +
+					grid[i][left] + grid[i][right] +
+					grid[down][left] + grid[down][j] + grid[down][right];
+			if(0 == grid[i][j] && 3 == sumAlive)
+				newGrid[i][j] = 1;
+			else if( 1 == grid[i][j] && (2 == sumAlive || 3 == sumAlive))
+				newGrid[i][j] = 1;
+			else
+				newGrid[i][j] = 0;
+		}
+}
+
+char initialCell(unsigned long long seed, long i, long j, long n){
+	//splitmix64 hash of cell index
+	uint64_t z = seed*0x9E3779B97F4A7C15ULL + (uint64_t)i*n + j;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	z ^= z >> 31;
+	return z >> 63;
+}
+
+char **sequentialLife(unsigned long long seed, int n, int ngen){
+	char **grid = allocate2D(n, n);
+	char **newGrid = allocate2D(n, n);
+	if(!grid || !newGrid)
+		return NULL;
+	for(int i=0; i<n; i++)
+		for(int j=0; j<n; j++)
+			grid[i][j] = initialCell(seed, i, j, n);
+	for(int k=0; k<ngen; k++){
+		for(int i=0; i<n; i++)
+			for(int j=0; j<n; j++){
+				int up = (i-1+n)%n;
+				int down = (i+1)%n;
+				int left = (j-1+n)%n;
+				int right = (j+1)%n;
+				int sumAlive = grid[up][left] + grid[up][j] + grid[up][right] +
+						grid[i][left] + grid[i][right] +
+						grid[down][left] + grid[down][j] + grid[down][right];
+				newGrid[i][j] = (3 == sumAlive) || (2 == sumAlive && grid[i][j]);
+			}
+		char ** temp = grid;
+		grid = newGrid;
+		newGrid = temp;
+	}
+	return grid;
+}
+
+char **allocate2D(int m, int n){
+		char *temp = malloc((size_t)m*n*sizeof(char));
+		char **a = malloc(m*sizeof(char *));
+		if(!temp || !a)
+			return NULL;
+		for(int i=0; i<m; i++)
+			a[i] = temp + (size_t)i*n;
+		return a;
+}
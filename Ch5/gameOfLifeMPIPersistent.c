@@ -0,0 +1,268 @@
+/* Copyright 2017 Eric Aubanel
+ * This file contains code extending Algorithm  5.4 from
+ * Elements of Parallel Computing, by Eric Aubanel, 2016, CRC Press.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------
+ * Parallel MPI implementation of Conway's Game of Life, with periodic
+ * boundary conditions, and overlap of computation and communication,
+ * using persistent communication requests for the halo exchange.
+ * The sends and receives of ghost rows are set up once with
+ * MPI_Send_init/MPI_Recv_init, and started each generation with
+ * MPI_Startall, saving the cost of setting up each message. Since grid
+ * and newGrid are swapped every generation, there are two sets of
+ * requests, one for each array.
+ * The time spent in each generation starting the exchange, updating
+ * interior rows, waiting for the exchange to complete and updating
+ * boundary rows is measured, and the average and maximum over
+ * generations (and processes) are reported, to show whether the
+ * exchange is hidden behind the interior update.
+ * Also includes initialization and display of grid.
+ * Assumes number of rows (n) divisible by number of processors (p).
+ * Process 0 has entire grid, plus two ghost rows (first and last).
+ * Other processes have grid with n/p + 2 rows (includes 2 ghost rows).
+ * If DISPLAY defined, displays grid after every DISP_FREQ generations,
+ * otherwise only displays initial and final grids.
+ * Grid diplayed by gathering it from all processes, then 
+ * process 0 writes it to file gameOfLifeMPI.txt.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "mpi.h"
+
+//update grid, store results in newGrid, for rows start to end, and n columns
+void updateGrid(char **grid, char **newGrid, int start, int end, int m, int n);
+//writes entire grid to file f
+void display(FILE *f, char **grid, int n);
+//called by process 0 to initialize grid with random values
+//using seed for rand(), or time(NULL) if seed is -1
+char **initialize(int seed, int n);
+//allocate char array with m rows and n columns
+char **allocate2D(int m, int n);
+//set up persistent exchange of ghost rows of grid (m rows, n columns)
+//with upper neighbour nbUp and lower neighbour nbDown in req[4]
+void initExchange(char **grid, int m, int n, int nbUp, int nbDown,
+		MPI_Request *req);
+
+//phases of each generation that are timed
+enum {START, INTERIOR, WAIT, BOUNDARY, NPHASES};
+
+#define DISP_FREQ 10
+
+int main(int argc, char **argv){
+	int n; // n x n grid
+	int ngen; // number of generations
+	char **grid; // Game grid
+	char **newGrid; //copy of grid
+	int id; //my id
+	int p; //number of processes
+	FILE *f; //grids written to this file
+	double time;
+
+	MPI_Request req[2][4]; //requests for exchange from grid and newGrid
+	MPI_Init(&argc, &argv);
+	MPI_Comm_rank(MPI_COMM_WORLD, &id);
+	MPI_Comm_size(MPI_COMM_WORLD, &p);
+
+	if(argc <2){
+		if(!id) fprintf(stderr,"usage: %s n [ngen [seed]]\n", argv[0]);
+		MPI_Finalize();
+		return 1;
+	}
+	n = strtol(argv[1], NULL, 10);
+	if(n%p){
+		if(!id) fprintf(stderr,"n must be divisible by number of processes\n");
+		MPI_Finalize();
+		return 1;
+	}
+	int m = n/p; //number of rows per process
+	
+	int seed;
+	if(!id){
+		if(4 == argc)
+			seed = strtol(argv[3], NULL, 10);
+		else
+			seed = -1;
+		grid = initialize(seed, n);
+	} else{
+		 grid = allocate2D(m+2, n);
+	}
+	if(grid == NULL){
+			if(!id) fprintf(stderr,"couldn't allocate memory for grid\n");
+			MPI_Finalize();
+	}
+
+	MPI_Scatter(&grid[1][0], m*n, MPI_CHAR, &grid[1][0], m*n, MPI_CHAR,
+							0, MPI_COMM_WORLD);
+
+	if(!id)
+		newGrid = allocate2D(n+2, n);
+	else
+		newGrid = allocate2D(m+2, n);
+	if(newGrid == NULL){
+		if(!id) fprintf(stderr,"couldn't allocate memory for newGrid\n");
+		MPI_Finalize();
+		return 1;
+	}
+	if(!id){
+		f = fopen("gameOfLifeMPI.txt","w");
+		display(f, grid, n);
+		if(argc > 2)
+			ngen = strtol(argv[2], NULL, 10);
+		else{
+			printf("enter number of generations: ");
+			fflush(stdout);
+			scanf("%d", &ngen);
+		}
+	}
+	MPI_Bcast(&ngen, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+	int nbDown = (id+1)%p; //lower neighbour
+	int nbUp = (id-1+p)%p; //upper neighbour
+	initExchange(grid, m, n, nbUp, nbDown, req[0]);
+	initExchange(newGrid, m, n, nbUp, nbDown, req[1]);
+	double phase[NPHASES] = {0.0}; //total time in each phase
+	double maxPhase[NPHASES] = {0.0}; //maximum time in one generation
+	MPI_Barrier(MPI_COMM_WORLD);
+	time = -MPI_Wtime();
+	for(int k=0; k<ngen; k++){
+		double t[NPHASES+1];
+		t[0] = MPI_Wtime();
+		//exhange boundary values
+		MPI_Startall(4, req[k%2]);
+		t[1] = MPI_Wtime();
+		updateGrid(grid, newGrid, 2, m-1, m, n);
+		t[2] = MPI_Wtime();
+		MPI_Waitall(4, req[k%2], MPI_STATUSES_IGNORE);
+		t[3] = MPI_Wtime();
+		updateGrid(grid, newGrid, 1, 1, m, n);
+		if(m > 1)
+			updateGrid(grid, newGrid, m, m, m, n);
+		t[4] = MPI_Wtime();
+		for(int i=0; i<NPHASES; i++){
+			phase[i] += t[i+1] - t[i];
+			if(t[i+1] - t[i] > maxPhase[i])
+				maxPhase[i] = t[i+1] - t[i];
+		}
+		char ** temp = grid;
+		grid = newGrid;
+		newGrid = temp;
+
+		#ifdef DISPLAY
+		if(!id && k % DISP_FREQ == 0){
+			MPI_Gather(&grid[1][0], m*n, MPI_CHAR, &grid[1][0], m*n, MPI_CHAR,
+								0, MPI_COMM_WORLD);
+		
+			display(f, grid, n);
+		}
+		#endif
+	}
+	time += MPI_Wtime();
+	double ptime;
+	MPI_Reduce(&time, &ptime, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+	double avg[NPHASES], pmax[NPHASES];
+	MPI_Reduce(phase, avg, NPHASES, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+	MPI_Reduce(maxPhase, pmax, NPHASES, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+	if(!id){
+		printf("time in seconds: %f\n", ptime);
+		const char *names[NPHASES] = {"start exchange", "interior update",
+				"wait for exchange", "boundary update"};
+		printf("per generation time in microseconds (average, maximum):\n");
+		for(int i=0; i<NPHASES; i++)
+			printf("%-18s %10.2f %10.2f\n", names[i],
+					ngen ? avg[i]/p/ngen*1e6 : 0.0, pmax[i]*1e6);
+		printf("\n");
+	}
+	for(int i=0; i<2; i++)
+		for(int j=0; j<4; j++)
+			MPI_Request_free(&req[i][j]);
+	MPI_Gather(&grid[1][0], m*n, MPI_CHAR, &grid[1][0], m*n, MPI_CHAR,
+						0, MPI_COMM_WORLD);
+	if(!id)
+		display(f, grid, n);
+	MPI_Finalize();
+	return 0;
+}
+
+void initExchange(char **grid, int m, int n, int nbUp, int nbDown,
+		MPI_Request *req){
+	MPI_Send_init(&grid[m][0], n, MPI_CHAR, nbDown, 1, MPI_COMM_WORLD, &req[0]);
+	MPI_Send_init(&grid[1][0], n, MPI_CHAR, nbUp, 2, MPI_COMM_WORLD, &req[1]);
+	MPI_Recv_init(&grid[m+1][0], n, MPI_CHAR, nbDown, 2, MPI_COMM_WORLD, &req[2]);
+	MPI_Recv_init(&grid[0][0], n, MPI_CHAR, nbUp, 1, MPI_COMM_WORLD, &req[3]);
+}
+
+void updateGrid(char **grid, char **newGrid, int start, int end, int m, int n){
+	for(int i=start; i<=end; i++)
+		for(int j=0; j<n; j++){
+			int up = i-1;
+			int down = i+1;
+			int left = (j-1+n)%n;
+			int right = (j+1)%n;
+			int sumAlive = grid[up][left] + grid[up][j] + grid[up][right] +
+					grid[i][left] + grid[i][right] + 
+					grid[down][left] + grid[down][j] + grid[down][right];
+			if(0 == grid[i][j] && 3 == sumAlive)
+				newGrid[i][j] = 1;
+			else if( 1 == grid[i][j] && (2 == sumAlive || 3 == sumAlive))
+				newGrid[i][j] = 1;
+			else
+				newGrid[i][j] = 0;
+		}
+}
+
+void display(FILE *f, char **grid, int n){
+	for(int i=1; i<=n; i++){
+		for(int j=0; j<n; j++){
+			char alive = 'o';
+			char dead = '.';
+			fprintf(f, "%c",grid[i][j]?alive:dead);
+		}
+		fputc('\n', f);
+	}
+}
+
+char **initialize(int seed, int n){
+	int nrows = 2+n;
+	char *temp = calloc(nrows*n, sizeof(char));
+	char **grid = malloc(nrows*sizeof(char *));
+	if(!temp || !grid)
+		return NULL;
+	if(-1 == seed)
+		srand(time(NULL));
+	else
+		srand(seed);
+	//leave first and last rows blank (ghost rows)
+	for(int i=n; i<(nrows-1)*n; i++)
+		if(rand() > RAND_MAX/2)
+			temp[i] = 1;
+	for(int i=0; i<nrows; i++)
+		grid[i] = temp + i*n;
+	return grid;
+}
+	
+char **allocate2D(int m, int n){
+		char *temp = malloc(m*n*sizeof(char));
+		char **a = malloc(m*sizeof(char *));
+		if(!temp || !a)
+			return NULL;
+		for(int i=0; i<m; i++)
+			a[i] = temp + i*n;
+		return a;
+}
+
+
@@ -0,0 +1,55 @@
+#!/bin/sh
+# Strong and weak scaling comparison of the row decomposition of
+# gameOfLifeMPI.c (Ch4) with the 2D decomposition of gameOfLifeMPI2D.c
+# (also run with a p x 1 process grid).
+# usage: gameOfLifeScaling.sh [n [ngen [maxp]]]
+# Strong scaling uses an n x n grid for all p; weak scaling keeps n^2/p
+# constant, starting from n for p = 1. The row version needs n divisible
+# by p, and at least 2 processes (process 0 only has one ghost row),
+# so it is skipped otherwise.
+# Set MPIRUN to change how programs are launched.
+
+n=${1:-2048}
+ngen=${2:-100}
+maxp=${3:-4}
+MPIRUN=${MPIRUN:-mpirun}
+dir=$(dirname "$0")
+
+mpicc -O2 -std=gnu99 -o gameOfLifeMPI "$dir/../Ch4/gameOfLifeMPI.c" || exit 1
+mpicc -O2 -std=gnu99 -o gameOfLifeMPI2D "$dir/gameOfLifeMPI2D.c" || exit 1
+
+# prints time in s for each version, with p processes and n x n grid
+run(){
+	p=$1
+	size=$2
+	if [ "$p" -gt 1 ] && [ $((size % p)) -eq 0 ]; then
+		# reads number of generations from stdin
+		row=$(echo "$ngen" | $MPIRUN -np "$p" ./gameOfLifeMPI "$size" 1 |
+				sed -n 's/.*time in seconds: //p')
+	else
+		row="-"
+	fi
+	rows=$($MPIRUN -np "$p" ./gameOfLifeMPI2D "$size" "$ngen" 1 rows |
+			sed -n 's/.*time in seconds: //p')
+	twod=$($MPIRUN -np "$p" ./gameOfLifeMPI2D "$size" "$ngen" 1 |
+			sed -n 's/.*time in seconds: //p')
+	printf "%4d %7d %12s %12s %12s\n" "$p" "$size" "$row" "$rows" "$twod"
+}
+
+echo "strong scaling, $ngen generations"
+printf "%4s %7s %12s %12s %12s\n" p n row row-2D 2D
+p=1
+while [ $p -le "$maxp" ]; do
+	run $p "$n"
+	p=$((p*2))
+done
+
+echo "weak scaling, $ngen generations"
+printf "%4s %7s %12s %12s %12s\n" p n row row-2D 2D
+p=1
+while [ $p -le "$maxp" ]; do
+	size=$(awk "BEGIN{printf \"%d\", $n*sqrt($p)}")
+	run $p "$size"
+	p=$((p*2))
+done
+rm -f gameOfLifeMPI.txt
@@ -18,11 +18,15 @@
  * -------------------------------------------------------------------
  * Implementation of Graham Scan for 2D convex hull. Inputs point 
  * coordinates in format x,y for each point, where x and y are integers. 
+ * Points are read from stdin, or the file given after n, which can
+ * also be a binary file (see pointLoader.h). If n is 0 all points in
+ * the file are used.
  * Sorts points lexicographically, computes upper hull, then outputs
  * points on upper hull.
  */
 #include <stdio.h>
 #include <stdlib.h>
+#include "pointLoader.h"
 
 typedef struct{
 	int num; //point number
@@ -42,10 +46,20 @@ int main(int argc, char **argv){
 	int m; //number of points on hull
 	
 	if(argc < 2){
-		fprintf(stderr,"usage: %s n\n", argv[0]);
+		fprintf(stderr,"usage: %s n [filename]\n", argv[0]);
 		return 1;
 	}
 	n = strtol(argv[1], NULL, 10);
+	long np; //number of points read
+	int *P = loadPointsInt(argc > 2 ? argv[2] : "-", 2, &np);
+	if(P == NULL)
+		return 1;
+	if(0 == n)
+		n = np;
+	if(np < n){
+		fprintf(stderr, "error in reading %d points\n", n);
+		return 1;
+	}
 	m = 0;
 	S = malloc(n*sizeof(PointT));
 	H = malloc(n*sizeof(PointT));
@@ -55,12 +69,11 @@ int main(int argc, char **argv){
 	}
 
 	for(int i=0; i<n; i++){
-		if(scanf("%d,%d", &S[i].x, &S[i].y) != 2){
-			fprintf(stderr, "error in reading %d points\n", n);
-			return 1;
-		}
+		S[i].x = P[2*i];
+		S[i].y = P[2*i+1];
 		S[i].num = i;
 	}
+	free(P);
 
 	qsort(S, n, sizeof(PointT), comparePoints);
 